@@ -20,20 +20,57 @@
 #else
  #include "WProgram.h"
 #endif
-#include <Wire.h>
 #include "Adafruit_MotorShield.h"
 #include <Adafruit_PWMServoDriver.h>
 #ifdef __AVR__
- #define WIRE Wire
-#else // Arduino Due
- #define WIRE Wire1
+ #include <avr/pgmspace.h>
+#else
+ #define pgm_read_word(addr) (*(const uint16_t *)(addr))
 #endif
 
 
+// Coil current over a quarter of the electrical cycle, 4096*sin(), already
+// in the form setPWM() takes: 4096 is full on, the rest is the 12 bit duty
 #if (MICROSTEPS == 8)
-uint8_t microstepcurve[] = {0, 50, 98, 142, 180, 212, 236, 250, 255};
+static const uint16_t microstepcurve[] PROGMEM = {
+  0, 799, 1567, 2276, 2896, 3406, 3784, 4017, 4096
+};
 #elif (MICROSTEPS == 16)
-uint8_t microstepcurve[] = {0, 25, 50, 74, 98, 120, 141, 162, 180, 197, 212, 225, 236, 244, 250, 253, 255};
+static const uint16_t microstepcurve[] PROGMEM = {
+  0, 401, 799, 1189, 1567, 1931, 2276, 2598, 2896, 3166, 3406, 3612,
+  3784, 3920, 4017, 4076, 4096
+};
+#elif (MICROSTEPS == 32)
+static const uint16_t microstepcurve[] PROGMEM = {
+  0, 201, 401, 601, 799, 995, 1189, 1380, 1567, 1751, 1931, 2106,
+  2276, 2440, 2598, 2751, 2896, 3035, 3166, 3290, 3406, 3513, 3612, 3703,
+  3784, 3857, 3920, 3973, 4017, 4052, 4076, 4091, 4096
+};
+#elif (MICROSTEPS == 64)
+static const uint16_t microstepcurve[] PROGMEM = {
+  0, 101, 201, 301, 401, 501, 601, 700, 799, 897, 995, 1092,
+  1189, 1285, 1380, 1474, 1567, 1660, 1751, 1842, 1931, 2019, 2106, 2191,
+  2276, 2359, 2440, 2520, 2598, 2675, 2751, 2824, 2896, 2967, 3035, 3102,
+  3166, 3229, 3290, 3349, 3406, 3461, 3513, 3564, 3612, 3659, 3703, 3745,
+  3784, 3822, 3857, 3889, 3920, 3948, 3973, 3996, 4017, 4036, 4052, 4065,
+  4076, 4085, 4091, 4095, 4096
+};
+#elif (MICROSTEPS == 128)
+static const uint16_t microstepcurve[] PROGMEM = {
+  0, 50, 101, 151, 201, 251, 301, 351, 401, 451, 501, 551,
+  601, 651, 700, 750, 799, 848, 897, 946, 995, 1044, 1092, 1141,
+  1189, 1237, 1285, 1332, 1380, 1427, 1474, 1521, 1567, 1614, 1660, 1706,
+  1751, 1797, 1842, 1886, 1931, 1975, 2019, 2062, 2106, 2149, 2191, 2234,
+  2276, 2317, 2359, 2399, 2440, 2480, 2520, 2559, 2598, 2637, 2675, 2713,
+  2751, 2788, 2824, 2861, 2896, 2932, 2967, 3001, 3035, 3068, 3102, 3134,
+  3166, 3198, 3229, 3260, 3290, 3320, 3349, 3378, 3406, 3433, 3461, 3487,
+  3513, 3539, 3564, 3588, 3612, 3636, 3659, 3681, 3703, 3724, 3745, 3765,
+  3784, 3803, 3822, 3839, 3857, 3873, 3889, 3905, 3920, 3934, 3948, 3961,
+  3973, 3985, 3996, 4007, 4017, 4027, 4036, 4044, 4052, 4059, 4065, 4071,
+  4076, 4081, 4085, 4088, 4091, 4093, 4095, 4096, 4096
+};
+#else
+#error "MICROSTEPS must be 8, 16, 32, 64 or 128"
 #endif
 
 Adafruit_MotorShield::Adafruit_MotorShield(uint8_t addr) {
@@ -42,13 +79,14 @@ Adafruit_MotorShield::Adafruit_MotorShield(uint8_t addr) {
 }
 
 void Adafruit_MotorShield::begin(uint16_t freq) {
-  // init PWM w/_freq
-  WIRE.begin();
+  // init PWM w/_freq, this also starts the queued I2C driver
   _pwm.begin();
   _freq = freq;
   _pwm.setPWMFreq(_freq);  // This is the maximum PWM frequency
+  // all channels off in one burst
   for (uint8_t i=0; i<16; i++) 
-    _pwm.setPWM(i, 0, 0);
+    _pwm.stagePWM(i, 0, 0);
+  _pwm.commitPWM();
 }
 
 void Adafruit_MotorShield::setPWM(uint8_t pin, uint16_t value) {
@@ -64,6 +102,26 @@ void Adafruit_MotorShield::setPin(uint8_t pin, boolean value) {
     _pwm.setPWM(pin, 4096, 0);
 }
 
+// Same as setPWM()/setPin() but only change the shadow image of the
+// PCA9685, commit() sends the staged channels in one burst
+void Adafruit_MotorShield::stagePWM(uint8_t pin, uint16_t value) {
+  if (value > 4095) {
+    _pwm.stagePWM(pin, 4096, 0);
+  } else 
+    _pwm.stagePWM(pin, 0, value);
+}
+void Adafruit_MotorShield::stagePin(uint8_t pin, boolean value) {
+  if (value == LOW)
+    _pwm.stagePWM(pin, 0, 0);
+  else
+    _pwm.stagePWM(pin, 4096, 0);
+}
+// Send everything staged on this shield, e.g. by stagestep() on both
+// steppers, in one transaction
+void Adafruit_MotorShield::commit(void) {
+  _pwm.commitPWM();
+}
+
 Adafruit_DCMotor *Adafruit_MotorShield::getMotor(uint8_t num) {
   if (num > 4) return NULL;
 
@@ -157,6 +215,7 @@ void Adafruit_DCMotor::setSpeed(uint8_t speed) {
 
 Adafruit_StepperMotor::Adafruit_StepperMotor(void) {
   revsteps = steppernum = currentstep = 0;
+  ocra = ocrb = 0;
 }
 /*
 
@@ -207,17 +266,26 @@ void Adafruit_StepperMotor::setSpeed(uint16_t rpm) {
 }
 
 void Adafruit_StepperMotor::release(void) {
-  MC->setPin(AIN1pin, LOW);
-  MC->setPin(AIN2pin, LOW);
-  MC->setPin(BIN1pin, LOW);
-  MC->setPin(BIN2pin, LOW);
-  MC->setPWM(PWMApin, 0);
-  MC->setPWM(PWMBpin, 0);
+  MC->stagePin(AIN1pin, LOW);
+  MC->stagePin(AIN2pin, LOW);
+  MC->stagePin(BIN1pin, LOW);
+  MC->stagePin(BIN2pin, LOW);
+  MC->stagePWM(PWMApin, 0);
+  MC->stagePWM(PWMBpin, 0);
+  MC->commit();
+  ocra = ocrb = 0;
+}
+
+// Turn the coil PWM of the current step down to percent of full to hold
+// the position with less heat. The next step goes back to full PWM
+void Adafruit_StepperMotor::hold(uint8_t percent) {
+  MC->setPWM(PWMApin, (uint32_t)ocra * percent / 100);
+  MC->setPWM(PWMBpin, (uint32_t)ocrb * percent / 100);
 }
 
 void Adafruit_StepperMotor::step(uint16_t steps, uint8_t dir,  uint8_t style) {
   uint32_t uspers = usperstep;
-  uint8_t ret = 0;
+  uint16_t ret = 0;
 
   if (style == INTERLEAVE) {
     uspers /= 2;
@@ -253,11 +321,17 @@ void Adafruit_StepperMotor::step(uint16_t steps, uint8_t dir,  uint8_t style) {
   }
 }
 
-uint8_t Adafruit_StepperMotor::onestep(uint8_t dir, uint8_t style) {
-  uint8_t a, b, c, d;
-  uint8_t ocrb, ocra;
+uint16_t Adafruit_StepperMotor::onestep(uint8_t dir, uint8_t style) {
+  uint16_t ret = stagestep(dir, style);
+  MC->commit();
+  return ret;
+}
 
-  ocra = ocrb = 255;
+// Same as onestep() but the new coil state is only staged on the shield,
+// call commit() on the shield to send it. Steppers on the same shield
+// that step together then share one transaction
+uint16_t Adafruit_StepperMotor::stagestep(uint8_t dir, uint8_t style) {
+  ocra = ocrb = 4096;
 
 
   // next determine what sort of stepping procedure we're up to
@@ -312,17 +386,17 @@ uint8_t Adafruit_StepperMotor::onestep(uint8_t dir, uint8_t style) {
 
     ocra = ocrb = 0;
     if ( (currentstep >= 0) && (currentstep < MICROSTEPS)) {
-      ocra = microstepcurve[MICROSTEPS - currentstep];
-      ocrb = microstepcurve[currentstep];
+      ocra = pgm_read_word(&microstepcurve[MICROSTEPS - currentstep]);
+      ocrb = pgm_read_word(&microstepcurve[currentstep]);
     } else if  ( (currentstep >= MICROSTEPS) && (currentstep < MICROSTEPS*2)) {
-      ocra = microstepcurve[currentstep - MICROSTEPS];
-      ocrb = microstepcurve[MICROSTEPS*2 - currentstep];
+      ocra = pgm_read_word(&microstepcurve[currentstep - MICROSTEPS]);
+      ocrb = pgm_read_word(&microstepcurve[MICROSTEPS*2 - currentstep]);
     } else if  ( (currentstep >= MICROSTEPS*2) && (currentstep < MICROSTEPS*3)) {
-      ocra = microstepcurve[MICROSTEPS*3 - currentstep];
-      ocrb = microstepcurve[currentstep - MICROSTEPS*2];
+      ocra = pgm_read_word(&microstepcurve[MICROSTEPS*3 - currentstep]);
+      ocrb = pgm_read_word(&microstepcurve[currentstep - MICROSTEPS*2]);
     } else if  ( (currentstep >= MICROSTEPS*3) && (currentstep < MICROSTEPS*4)) {
-      ocra = microstepcurve[currentstep - MICROSTEPS*3];
-      ocrb = microstepcurve[MICROSTEPS*4 - currentstep];
+      ocra = pgm_read_word(&microstepcurve[currentstep - MICROSTEPS*3]);
+      ocrb = pgm_read_word(&microstepcurve[MICROSTEPS*4 - currentstep]);
     }
   }
 
@@ -334,8 +408,8 @@ uint8_t Adafruit_StepperMotor::onestep(uint8_t dir, uint8_t style) {
   Serial.print(" pwmA = "); Serial.print(ocra, DEC); 
   Serial.print(" pwmB = "); Serial.println(ocrb, DEC); 
 #endif
-  MC->setPWM(PWMApin, ocra*17);
-  MC->setPWM(PWMBpin, ocrb*17);
+  MC->stagePWM(PWMApin, ocra);
+  MC->stagePWM(PWMBpin, ocrb);
   
 
   // release all
@@ -385,27 +459,27 @@ uint8_t Adafruit_StepperMotor::onestep(uint8_t dir, uint8_t style) {
 
   if (latch_state & 0x1) {
    // Serial.println(AIN2pin);
-    MC->setPin(AIN2pin, HIGH);
+    MC->stagePin(AIN2pin, HIGH);
   } else {
-    MC->setPin(AIN2pin, LOW);
+    MC->stagePin(AIN2pin, LOW);
   }
   if (latch_state & 0x2) {
-    MC->setPin(BIN1pin, HIGH);
+    MC->stagePin(BIN1pin, HIGH);
    // Serial.println(BIN1pin);
   } else {
-    MC->setPin(BIN1pin, LOW);
+    MC->stagePin(BIN1pin, LOW);
   }
   if (latch_state & 0x4) {
-    MC->setPin(AIN1pin, HIGH);
+    MC->stagePin(AIN1pin, HIGH);
    // Serial.println(AIN1pin);
   } else {
-    MC->setPin(AIN1pin, LOW);
+    MC->stagePin(AIN1pin, LOW);
   }
   if (latch_state & 0x8) {
-    MC->setPin(BIN2pin, HIGH);
+    MC->stagePin(BIN2pin, HIGH);
    // Serial.println(BIN2pin);
   } else {
-    MC->setPin(BIN2pin, LOW);
+    MC->stagePin(BIN2pin, LOW);
   }
 
   return currentstep;
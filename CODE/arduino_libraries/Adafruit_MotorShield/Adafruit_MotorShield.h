@@ -18,12 +18,16 @@
 #define _Adafruit_MotorShield_h_
 
 #include <inttypes.h>
-#include <Wire.h>
 #include "utility/Adafruit_PWMServoDriver.h"
+#include "utility/twi_queue.h"
 
 //#define MOTORDEBUG
 
-#define MICROSTEPS 16         // 8 or 16
+// 8, 16, 32, 64 or 128. Every microstep is two channel writes on I2C, so
+// the top speed in MICROSTEP style drops as this goes up
+#ifndef MICROSTEPS
+#define MICROSTEPS 16
+#endif
 
 #define MOTOR1_A 2
 #define MOTOR1_B 3
@@ -67,7 +71,9 @@ class Adafruit_StepperMotor {
 
   void step(uint16_t steps, uint8_t dir,  uint8_t style = SINGLE);
   void setSpeed(uint16_t);
-  uint8_t onestep(uint8_t dir, uint8_t style);
+  uint16_t onestep(uint8_t dir, uint8_t style);
+  uint16_t stagestep(uint8_t dir, uint8_t style);
+  void hold(uint8_t percent);
   void release(void);
   uint32_t usperstep, steppingcounter;
 
@@ -75,7 +81,8 @@ class Adafruit_StepperMotor {
   uint8_t PWMApin, AIN1pin, AIN2pin;
   uint8_t PWMBpin, BIN1pin, BIN2pin;
   uint16_t revsteps; // # steps per revolution
-  uint8_t currentstep;
+  uint16_t currentstep;
+  uint16_t ocra, ocrb; // full coil PWM of the current step
   Adafruit_MotorShield *MC;
   uint8_t steppernum;
 };
@@ -89,6 +96,9 @@ class Adafruit_MotorShield
 
     void setPWM(uint8_t pin, uint16_t val);
     void setPin(uint8_t pin, boolean val);
+    void stagePWM(uint8_t pin, uint16_t val);
+    void stagePin(uint8_t pin, boolean val);
+    void commit(void);
     Adafruit_DCMotor *getMotor(uint8_t n);
     Adafruit_StepperMotor *getStepper(uint16_t steps, uint8_t n);
  private:
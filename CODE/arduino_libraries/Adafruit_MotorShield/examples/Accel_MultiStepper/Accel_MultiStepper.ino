@@ -9,7 +9,6 @@
 // Will not work with v1 shields
 
 #include <AccelStepper.h>
-#include <Wire.h>
 #include <Adafruit_MotorShield.h>
 #include "utility/Adafruit_PWMServoDriver.h"
 
@@ -7,7 +7,6 @@ For use with the Adafruit Motor Shield v2
 ---->	http://www.adafruit.com/products/1438
 */
 
-#include <Wire.h>
 #include <Adafruit_MotorShield.h>
 #include "utility/Adafruit_PWMServoDriver.h"
 
@@ -12,7 +12,6 @@ Connect a DC motor to M1
 Connect a hobby servo to SERVO1
 */
 
-#include <Wire.h>
 #include <Adafruit_MotorShield.h>
 #include "utility/Adafruit_PWMServoDriver.h"
 #include <Servo.h> 
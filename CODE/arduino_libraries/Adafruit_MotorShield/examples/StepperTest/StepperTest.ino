@@ -8,7 +8,6 @@ For use with the Adafruit Motor Shield v2
 */
 
 
-#include <Wire.h>
 #include <Adafruit_MotorShield.h>
 #include "utility/Adafruit_PWMServoDriver.h"
 
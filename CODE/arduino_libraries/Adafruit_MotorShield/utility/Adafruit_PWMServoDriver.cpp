@@ -16,19 +16,22 @@
  ****************************************************/
 
 #include <Adafruit_PWMServoDriver.h>
-#include <Wire.h>
-#ifdef __AVR__
- #define WIRE Wire
-#else // Arduino Due
- #define WIRE Wire1
-#endif
+#include "twi_queue.h"
 
 Adafruit_PWMServoDriver::Adafruit_PWMServoDriver(uint8_t addr) {
   _i2caddr = addr;
+  for (uint8_t i=0; i<16; i++) {
+    _on[i] = _off[i] = 0;
+  }
+  _known = _dirty = 0;
+  _errors = 0;
 }
 
 void Adafruit_PWMServoDriver::begin(void) {
- WIRE.begin();
+ // the chip may still hold anything from before a reset of the Arduino
+ _known = _dirty = 0;
+ twi_queue_begin();
+ _errors = twi_queue_errors();
  reset();
 }
 
@@ -54,6 +57,7 @@ void Adafruit_PWMServoDriver::setPWMFreq(float freq) {
   write8(PCA9685_MODE1, newmode); // go to sleep
   write8(PCA9685_PRESCALE, prescale); // set the prescaler
   write8(PCA9685_MODE1, oldmode);
+  twi_queue_flush();  // the oscillator needs 500us after it is woken up
   delay(5);
   write8(PCA9685_MODE1, oldmode | 0xa1);  //  This sets the MODE1 register to turn on auto increment.
                                           // This is why the beginTransmission below was not working.
@@ -63,48 +67,96 @@ void Adafruit_PWMServoDriver::setPWMFreq(float freq) {
 void Adafruit_PWMServoDriver::setPWM(uint8_t num, uint16_t on, uint16_t off) {
   //Serial.print("Setting PWM "); Serial.print(num); Serial.print(": "); Serial.print(on); Serial.print("->"); Serial.println(off);
 
-  WIRE.beginTransmission(_i2caddr);
-#if ARDUINO >= 100
-  WIRE.write(LED0_ON_L+4*num);
-  WIRE.write(on);
-  WIRE.write(on>>8);
-  WIRE.write(off);
-  WIRE.write(off>>8);
-#else
-  WIRE.send(LED0_ON_L+4*num);
-  WIRE.send((uint8_t)on);
-  WIRE.send((uint8_t)(on>>8));
-  WIRE.send((uint8_t)off);
-  WIRE.send((uint8_t)(off>>8));
-#endif
-  WIRE.endTransmission();
+  uint16_t bit = (uint16_t)1 << num;
+  checkErrors();
+  // already there
+  if ((_known & bit) && _on[num] == on && _off[num] == off) return;
+
+  _on[num] = on;
+  _off[num] = off;
+  _known |= bit;
+  _dirty &= ~bit;
+  twi_queue_beginTransmission(_i2caddr);
+  twi_queue_put(LED0_ON_L+4*num);
+  twi_queue_put(on);
+  twi_queue_put(on>>8);
+  twi_queue_put(off);
+  twi_queue_put(off>>8);
+  twi_queue_endTransmission();
+}
+
+// Change a channel in the shadow image only, commitPWM() or writePWM() sends it.
+// A channel staged with the value the chip already has is not sent at all
+void Adafruit_PWMServoDriver::stagePWM(uint8_t num, uint16_t on, uint16_t off) {
+  uint16_t bit = (uint16_t)1 << num;
+  checkErrors();
+  if ((_known & bit) && _on[num] == on && _off[num] == off) return;
+
+  _on[num] = on;
+  _off[num] = off;
+  _known &= ~bit;
+  _dirty |= bit;
+}
+
+// Send the channels staged since the last commit, one burst per run of
+// adjacent dirty channels. Bridging a clean channel would cost its 4 bytes,
+// more than the register address and START/STOP of another transaction
+void Adafruit_PWMServoDriver::commitPWM(void) {
+  uint8_t i = 0;
+  while (_dirty) {
+    while (!(_dirty & ((uint16_t)1 << i))) i++;
+    uint8_t first = i;
+    while (i < 16 && (_dirty & ((uint16_t)1 << i))) i++;
+    writePWM(first, i - first);
+  }
+}
+
+// A channel counts as known once its write is queued. If a transaction
+// fails on the bus later on, any channel may differ from the image. The
+// error count does not tell which chip on the bus it was, so the channels
+// known so far are staged again and the next commit resends them
+void Adafruit_PWMServoDriver::checkErrors(void) {
+  uint8_t errors = twi_queue_errors();
+  if (errors != _errors) {
+    _errors = errors;
+    _dirty |= _known;
+    _known = 0;
+  }
+}
+
+// Queue count channels from the shadow image starting at channel first.
+// MODE1 auto-increment is on (see setPWMFreq) so each burst is a single
+// transaction: the address of LEDfirst_ON_L followed by 4 bytes per channel.
+// Returns as soon as it is queued, the TWI interrupt sends it
+void Adafruit_PWMServoDriver::writePWM(uint8_t first, uint8_t count) {
+  while (count) {
+    uint8_t n = count;
+    if (n > PCA9685_BURST_CHANNELS) n = PCA9685_BURST_CHANNELS;
+
+    twi_queue_beginTransmission(_i2caddr);
+    twi_queue_put(LED0_ON_L+4*first);
+    for (uint8_t i=first; i<first+n; i++) {
+      twi_queue_put(_on[i]);
+      twi_queue_put(_on[i]>>8);
+      twi_queue_put(_off[i]);
+      twi_queue_put(_off[i]>>8);
+      _known |= (uint16_t)1 << i;
+      _dirty &= ~((uint16_t)1 << i);
+    }
+    twi_queue_endTransmission();
+
+    first += n;
+    count -= n;
+  }
 }
 
 uint8_t Adafruit_PWMServoDriver::read8(uint8_t addr) {
-  WIRE.beginTransmission(_i2caddr);
-#if ARDUINO >= 100
-  WIRE.write(addr);
-#else
-  WIRE.send(addr);
-#endif
-  WIRE.endTransmission();
-
-  WIRE.requestFrom((uint8_t)_i2caddr, (uint8_t)1);
-#if ARDUINO >= 100
-  return WIRE.read();
-#else
-  return WIRE.receive();
-#endif
+  return twi_queue_read8(_i2caddr, addr);
 }
 
 void Adafruit_PWMServoDriver::write8(uint8_t addr, uint8_t d) {
-  WIRE.beginTransmission(_i2caddr);
-#if ARDUINO >= 100
-  WIRE.write(addr);
-  WIRE.write(d);
-#else
-  WIRE.send(addr);
-  WIRE.send(d);
-#endif
-  WIRE.endTransmission();
+  twi_queue_beginTransmission(_i2caddr);
+  twi_queue_put(addr);
+  twi_queue_put(d);
+  twi_queue_endTransmission();
 }
@@ -0,0 +1,241 @@
+/***************************************************
+  Queued, interrupt driven I2C master for the motor shield PCA9685s
+
+  BSD license, all text above must be included in any redistribution
+ ****************************************************/
+
+#include "twi_queue.h"
+
+#ifdef __AVR__
+
+#include <avr/interrupt.h>
+#include <util/twi.h>
+
+// Ring of transactions, each one is [length][SLA+R/W][data...]
+// where length counts the bytes after it
+static uint8_t ring[TWI_QUEUE_BUFFER_SIZE];
+static volatile uint8_t head;  // end of the committed transactions
+static volatile uint8_t tail;  // next byte for the interrupt
+static uint8_t wr;             // producer write index, ahead of head while building
+static uint8_t len_pos, len;   // length byte of the transaction being built
+
+static volatile boolean busy;
+static volatile uint8_t tx_left;  // bytes left in the transaction on the bus
+static volatile uint8_t rx;
+static volatile uint8_t errors;
+static boolean started;
+
+#define TWCR_ACK (_BV(TWEN) | _BV(TWIE) | _BV(TWINT))
+
+static inline uint8_t next(uint8_t i) {
+  return (i + 1) % TWI_QUEUE_BUFFER_SIZE;
+}
+
+void twi_queue_begin(void) {
+  if (started) return;
+  started = true;
+
+  head = tail = wr = 0;
+  busy = false;
+  errors = 0;
+
+  // internal pull-ups, same as Wire
+#if defined(SDA) && defined(SCL)
+  digitalWrite(SDA, 1);
+  digitalWrite(SCL, 1);
+#endif
+  twi_queue_setClock(TWI_QUEUE_FREQ);
+  TWCR = _BV(TWEN);
+}
+
+// SCL = F_CPU / (16 + 2 * TWBR), prescaler 1. At 16MHz Fast-mode Plus
+// is TWBR = 0, the fastest the TWI can go
+void twi_queue_setClock(uint32_t freq) {
+  twi_queue_flush();
+  TWSR &= ~(_BV(TWPS0) | _BV(TWPS1));
+  if (freq >= F_CPU / 16) {
+    TWBR = 0;
+  } else {
+    TWBR = ((F_CPU / freq) - 16) / 2;
+  }
+}
+
+static void put_raw(uint8_t data) {
+  uint8_t n = next(wr);
+  while (n == tail) ;  // full, the interrupt is draining it
+  ring[wr] = data;
+  wr = n;
+}
+
+void twi_queue_beginTransmission(uint8_t addr) {
+  wr = head;
+  len_pos = wr;
+  put_raw(0);
+  len = 0;
+  twi_queue_put(addr << 1);  // SLA+W
+}
+
+void twi_queue_put(uint8_t data) {
+  put_raw(data);
+  len++;
+}
+
+void twi_queue_endTransmission(void) {
+  ring[len_pos] = len;
+  uint8_t sreg = SREG;
+  cli();
+  head = wr;
+  if (!busy) {
+    busy = true;
+    while (TWCR & _BV(TWSTO)) ;  // last STOP still going out
+    TWCR = TWCR_ACK | _BV(TWSTA);
+  }
+  SREG = sreg;
+}
+
+void twi_queue_flush(void) {
+  while (busy) ;
+}
+
+uint8_t twi_queue_read8(uint8_t addr, uint8_t reg) {
+  twi_queue_beginTransmission(addr);
+  twi_queue_put(reg);
+  twi_queue_endTransmission();
+
+  // a read is a transaction with only SLA+R
+  wr = head;
+  len_pos = wr;
+  put_raw(0);
+  len = 0;
+  twi_queue_put((addr << 1) | TW_READ);
+  twi_queue_endTransmission();
+
+  twi_queue_flush();
+  return rx;
+}
+
+uint8_t twi_queue_errors(void) {
+  return errors;
+}
+
+// STOP the current transaction and START the next one in the same go
+static void next_transaction(void) {
+  if (head != tail) {
+    TWCR = TWCR_ACK | _BV(TWSTO) | _BV(TWSTA);
+  } else {
+    TWCR = _BV(TWEN) | _BV(TWINT) | _BV(TWSTO);
+    busy = false;
+  }
+}
+
+// drop the rest of a transaction the bus did not take
+static void skip_transaction(void) {
+  while (tx_left) {
+    tail = next(tail);
+    tx_left--;
+  }
+  errors++;
+}
+
+ISR(TWI_vect) {
+  switch (TW_STATUS) {
+  case TW_START:
+  case TW_REP_START:
+    tx_left = ring[tail] - 1;
+    tail = next(tail);
+    TWDR = ring[tail];
+    tail = next(tail);
+    TWCR = TWCR_ACK;
+    break;
+
+  case TW_MT_SLA_ACK:
+  case TW_MT_DATA_ACK:
+    if (tx_left) {
+      TWDR = ring[tail];
+      tail = next(tail);
+      tx_left--;
+      TWCR = TWCR_ACK;
+    } else {
+      next_transaction();
+    }
+    break;
+
+  case TW_MR_SLA_ACK:
+    // single byte, clear TWEA so it is NACKed
+    TWCR = TWCR_ACK;
+    break;
+
+  case TW_MR_DATA_NACK:
+    rx = TWDR;
+    next_transaction();
+    break;
+
+  case TW_MT_SLA_NACK:
+  case TW_MT_DATA_NACK:
+  case TW_MR_SLA_NACK:
+    skip_transaction();
+    next_transaction();
+    break;
+
+  case TW_MT_ARB_LOST:
+    // release the bus and START again when it is free
+    skip_transaction();
+    if (head != tail) {
+      TWCR = TWCR_ACK | _BV(TWSTA);
+    } else {
+      TWCR = _BV(TWEN) | _BV(TWINT);
+      busy = false;
+    }
+    break;
+
+  default:
+    // bus error, STOP resets the TWI
+    skip_transaction();
+    next_transaction();
+    break;
+  }
+}
+
+#else // Arduino Due, blocking Wire1
+
+#include <Wire.h>
+
+static uint8_t errors;
+
+void twi_queue_begin(void) {
+  Wire1.begin();
+  Wire1.setClock(TWI_QUEUE_FREQ);
+}
+
+void twi_queue_setClock(uint32_t freq) {
+  Wire1.setClock(freq);
+}
+
+void twi_queue_beginTransmission(uint8_t addr) {
+  Wire1.beginTransmission(addr);
+}
+
+void twi_queue_put(uint8_t data) {
+  Wire1.write(data);
+}
+
+void twi_queue_endTransmission(void) {
+  if (Wire1.endTransmission() != 0) errors++;
+}
+
+void twi_queue_flush(void) {
+}
+
+uint8_t twi_queue_read8(uint8_t addr, uint8_t reg) {
+  twi_queue_beginTransmission(addr);
+  twi_queue_put(reg);
+  twi_queue_endTransmission();
+  Wire1.requestFrom((uint8_t)addr, (uint8_t)1);
+  return Wire1.read();
+}
+
+uint8_t twi_queue_errors(void) {
+  return errors;
+}
+
+#endif
@@ -0,0 +1,50 @@
+/***************************************************
+  Queued, interrupt driven I2C master for the motor shield PCA9685s
+
+  Transactions are built straight into a ring buffer and the TWI
+  interrupt sends them back to back (STOP and the next START go out
+  together), so the CPU only spends time on the bus when a byte is
+  done instead of spinning on every bit like Wire does.
+
+  There must be a single producer: either the main loop or one
+  interrupt, never both at the same time. twi_queue_put() waits when
+  the ring is full, so it must run with interrupts enabled.
+
+  On boards other than AVR this falls back to a blocking Wire1.
+
+  BSD license, all text above must be included in any redistribution
+ ****************************************************/
+
+#ifndef _TWI_QUEUE_H
+#define _TWI_QUEUE_H
+
+#if ARDUINO >= 100
+ #include "Arduino.h"
+#else
+ #include "WProgram.h"
+#endif
+
+#define TWI_QUEUE_FREQ 400000L      // Fast-mode
+#define TWI_QUEUE_FREQ_FMPLUS 1000000L // Fast-mode Plus, the PCA9685 supports it
+
+// bytes of queued transactions, a transaction takes its length plus 2
+#define TWI_QUEUE_BUFFER_SIZE 128
+
+void twi_queue_begin(void);
+void twi_queue_setClock(uint32_t freq);
+
+// queue a write transaction: begin, put the bytes, end
+void twi_queue_beginTransmission(uint8_t addr);
+void twi_queue_put(uint8_t data);
+void twi_queue_endTransmission(void);
+
+// wait until everything queued is on the bus
+void twi_queue_flush(void);
+
+// write reg, then read one byte back. Blocks until done
+uint8_t twi_queue_read8(uint8_t addr, uint8_t reg);
+
+// number of transactions the slave did not acknowledge
+uint8_t twi_queue_errors(void);
+
+#endif
@@ -0,0 +1,148 @@
+#!/usr/bin/env python
+"""\
+
+Encode an image for the grbl laser raster mode
+
+Converts a grayscale image into '$LS=' scanline setup and '$L='
+pixel lines for grbl compiled with ENABLE_LASER_RASTER. Each
+image row is one scanline along X, scanned from left to right,
+or in alternating directions with --bidirectional. Darker pixels
+get more laser power. Blank rows are skipped and every scanline
+is padded with unpowered overscan pixels, so the laser only
+fires once the feed rate is reached. The output is plain text,
+which may be streamed with stream.py like any g-code program.
+
+PAYLOAD FORMAT:
+  Each pixel is one base32 character (0-9, A-V) with the power
+  0-31 of the full scale '$LS=' S value. A '*' and a base32
+  count n repeat the next pixel n+2 times. For example,
+  '$L=*30V' is five unpowered pixels and one full power pixel.
+  grbl upcases the lines and drops whitespace, '/' and comments,
+  so the alphabet avoids all of these.
+
+REQUIREMENTS:
+  - Python 2.7 or 3.x with the Pillow imaging library
+
+---------------------
+The MIT License (MIT)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+---------------------
+"""
+
+import sys
+import math
+import argparse
+
+BASE32 = '0123456789ABCDEFGHIJKLMNOPQRSTUV'
+POWER_MAX = 31
+MAX_PAYLOAD = 64 # Payload characters per line. Keeps lines well inside grbl's line buffer.
+
+def encode_runs(pixels):
+    """Returns the payload tokens of a list of pixel powers, run-length encoded."""
+    tokens = []
+    i = 0
+    while i < len(pixels):
+        n = 1
+        while i+n < len(pixels) and pixels[i+n] == pixels[i]:
+            n += 1
+        i += n
+        while n > 0:
+            if n >= 2:
+                k = min(n, len(BASE32)+1)
+                tokens.append('*' + BASE32[k-2] + BASE32[pixels[i-1]])
+            else:
+                k = 1
+                tokens.append(BASE32[pixels[i-1]])
+            n -= k
+    return tokens
+
+def payload_lines(tokens):
+    """Splits the payload tokens into '$L=' lines."""
+    line = ''
+    for t in tokens:
+        if len(line) + len(t) > MAX_PAYLOAD:
+            yield '$L=' + line
+            line = ''
+        line += t
+    if line:
+        yield '$L=' + line
+
+def main():
+    parser = argparse.ArgumentParser(description='Encode an image for the grbl laser raster mode.')
+    parser.add_argument('image', help='image file. Converted to 8-bit grayscale.')
+    parser.add_argument('-o', '--output', type=argparse.FileType('w'), default=sys.stdout,
+            help='output file (default: stdout)')
+    parser.add_argument('-p', '--pitch', type=float, default=0.1,
+            help='pixel pitch along X in mm (default: 0.1)')
+    parser.add_argument('-l', '--line-pitch', type=float,
+            help='scanline pitch along Y in mm (default: pixel pitch)')
+    parser.add_argument('-f', '--feed', type=float, default=3000.0,
+            help='scanline feed rate in mm/min (default: 3000)')
+    parser.add_argument('-s', '--power', type=float, default=1000.0,
+            help='full scale laser power S (default: 1000)')
+    parser.add_argument('-x', '--origin-x', type=float, default=0.0,
+            help='work X of the image left edge in mm (default: 0)')
+    parser.add_argument('-y', '--origin-y', type=float, default=0.0,
+            help='work Y of the image bottom edge in mm (default: 0)')
+    parser.add_argument('-v', '--overscan', type=float, default=2.0,
+            help='unpowered run-up on each side of a scanline in mm (default: 2)')
+    parser.add_argument('-b', '--bidirectional', action='store_true',
+            help='scan every other row from right to left')
+    parser.add_argument('-i', '--invert', action='store_true',
+            help='lighter pixels get more power')
+    args = parser.parse_args()
+
+    from PIL import Image
+    image = Image.open(args.image).convert('L')
+    width, height = image.size
+    data = list(image.getdata())
+    line_pitch = args.line_pitch if args.line_pitch else args.pitch
+    overscan = int(math.ceil(args.overscan/args.pitch))
+
+    out = args.output
+    out.write('G21 G90\n')
+    out.write('M4 S0\n') # Dynamic laser power keeps the pixel density in ramps.
+    reverse = False
+    for row in range(height):
+        gray = data[row*width:(row+1)*width]
+        if args.invert:
+            pixels = [int(round(g*POWER_MAX/255.0)) for g in gray]
+        else:
+            pixels = [int(round((255-g)*POWER_MAX/255.0)) for g in gray]
+        if not any(pixels):
+            continue # Skip blank rows.
+        y = args.origin_y + (height-1-row)*line_pitch
+        pixels = [0]*overscan + pixels + [0]*overscan
+        if reverse:
+            x = args.origin_x + (width+overscan)*args.pitch
+            pitch = -args.pitch
+            pixels.reverse()
+        else:
+            x = args.origin_x - overscan*args.pitch
+            pitch = args.pitch
+        out.write('$LS=X%.3fY%.3fP%.4fF%.0fS%.0f\n' % (x, y, pitch, args.feed, args.power))
+        for line in payload_lines(encode_runs(pixels)):
+            out.write(line + '\n')
+        if args.bidirectional:
+            reverse = not reverse
+    out.write('M5\n')
+
+if __name__ == '__main__':
+    main()
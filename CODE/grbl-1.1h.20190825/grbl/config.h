@@ -37,10 +37,22 @@
 #define DEFAULTS_GENERIC
 #define CPU_MAP_ATMEGA328P // Arduino Uno CPU
 
-// Serial baud rate
+// Serial baud rate. With ENABLE_BAUD_RATE_SETTING, this is the default and fallback baud rate upon
+// restoring settings.
 // #define BAUD_RATE 230400
 #define BAUD_RATE 115200
 
+// Enables the '$40' setting, which changes the active baud rate at runtime to 115200, 230400,
+// 250000, 500000, or 1000000. The rollback of an unconfirmed change needs the millisecond system
+// tick on Timer2, which is otherwise only started for the features using it.
+// #define ENABLE_BAUD_RATE_SETTING // Default disabled. Uncomment to enable.
+
+// After a '$40' baud rate change, Grbl reverts to the prior baud rate if it does not receive a
+// valid line at the new baud rate within this time. The new baud rate is only stored in EEPROM
+// once confirmed, so an unreachable baud rate can't lock out the host.
+// NOTE: Only used with ENABLE_BAUD_RATE_SETTING.
+#define SERIAL_BAUD_ROLLBACK_TIMEOUT 5.0 // Float (seconds)
+
 // Define realtime command special characters. These characters are 'picked-off' directly from the
 // serial read data stream and are not passed to the grbl line execution parser. Select characters
 // that do not and must not exist in the streamed g-code program. ASCII control characters may be
@@ -64,6 +76,7 @@
 #define CMD_SAFETY_DOOR 0x84
 #define CMD_JOG_CANCEL  0x85
 #define CMD_DEBUG_REPORT 0x86 // Only when DEBUG enabled, sends debug report in '{}' braces.
+#define CMD_BINARY_STATUS_REPORT 0x87 // Only when ENABLE_BINARY_STATUS_REPORT enabled. See report.h.
 #define CMD_FEED_OVR_RESET 0x90         // Restores feed override value to 100%.
 #define CMD_FEED_OVR_COARSE_PLUS 0x91
 #define CMD_FEED_OVR_COARSE_MINUS 0x92
@@ -117,6 +130,15 @@
 // greater.
 #define N_HOMING_LOCATE_CYCLE 1 // Integer (1-128)
 
+// By default, the homing cycle polls the limit switches between step segment preparations and stops
+// an axis up to a few hundred microseconds after its switch triggers. The overshoot grows with the
+// seek rate and limits how fast '$25' can be set. This option enables the limit pin change interrupt
+// during the homing approaches, which stops an axis the instant its switch triggers, so the pull-off
+// is measured from the exact trigger position. The '$25' seek rate can typically be raised 2-3x,
+// while the '$24' locate rate and a single locate cycle keep the final precision.
+// NOTE: Polling remains active as a fallback. Not supported with the dual axis feature.
+// #define HOMING_INTERRUPT_LATCH // Default disabled. Uncomment to enable.
+
 // Enables single axis homing commands. $HX, $HY, and $HZ for X, Y, and Z-axis homing. The full homing 
 // cycle is still invoked by the $H command. This is disabled by default. It's here only to address
 // users that need to switch between a two-axis and three-axis machine. This is actually very rare.
@@ -179,6 +201,18 @@
 #define SAFETY_DOOR_SPINDLE_DELAY 4.0 // Float (seconds)
 #define SAFETY_DOOR_COOLANT_DELAY 1.0 // Float (seconds)
 
+// Lets the spindle spin up during the rapids leading to the next feed motion. Normally, starting
+// the spindle with M3 or M4 empties the planner buffer first, and a G4 dwell must give it time to
+// reach speed. With this option, a spindle change only waits for the queued feed motions, so it
+// happens while any queued rapids keep moving. When the spindle starts or reverses, feed motions
+// are then held until the spin-up time below has elapsed since the M3/M4, without emptying the
+// planner. Rapids, jogs and probe cycles are never held. Spindle speed changes alone don't wait for
+// the spin-up time, but they wait until the stepper has completed the last feed motion. M5 empties
+// the planner buffer as before, so the spindle keeps running through a queued retract.
+// NOTE: Not used in laser mode, which already synchronizes the laser with the motions.
+// #define SPINDLE_SPINUP_OVERLAP // Default disabled. Uncomment to enable.
+#define SPINDLE_SPINUP_TIME 3000 // msec (0-65535)
+
 // Enable CoreXY kinematics. Use ONLY with CoreXY machines.
 // IMPORTANT: If homing is enabled, you must reconfigure the homing cycle #defines above to
 // #define HOMING_CYCLE_0 (1<<X_AXIS) and #define HOMING_CYCLE_1 (1<<Y_AXIS)
@@ -273,6 +307,27 @@
 #define REPORT_FIELD_OVERRIDES // Default enabled. Comment to disable.
 #define REPORT_FIELD_LINE_NUMBERS // Default enabled. Comment to disable.
 
+// Prints the status report positions from the machine steps with a 32x32-bit fixed-point multiply
+// per axis, rather than a float division and the float formatting. The output is byte for byte the
+// same. Positions close to a rounding boundary, e.g. the odd steps at 80 steps/mm, still take the
+// float path, so this only pays off at steps/mm values where few positions do. It needs 64-bit
+// intermediates, which cost flash and are slow on the AVR. See test/test_print.c for a timing run.
+// #define REPORT_POSITION_FIXED_POINT // Default disabled. Uncomment to enable.
+
+// Enables the binary status report realtime command 0x87. It sends the state, the machine position
+// in steps, the buffer states and the overrides as a compact binary frame, without float formatting.
+// Meant for GUIs polling at high rates. See report.h for the frame and the interface documentation.
+// #define ENABLE_BINARY_STATUS_REPORT // Default disabled. Uncomment to enable.
+
+// Enables runtime performance counters, which tell whether a slow job is bound by the serial link,
+// the g-code parser, or the planner. The '$P' command reports them as '[PC:...]' and the optional
+// status report field below as '|Pc:...', both in the order: serial RX buffer full events, lines
+// executed per second, planner buffer empty events, step segment buffer underruns, the average
+// block peak speed in percent of the programmed rate, and zero-length blocks rejected by the
+// planner. All counters are cleared by a reset. See the interface documentation for details.
+// #define ENABLE_PERF_COUNTERS // Default disabled. Uncomment to enable.
+// #define REPORT_FIELD_PERF_COUNTERS // Default disabled. Uncomment to enable. Requires ENABLE_PERF_COUNTERS.
+
 // Some status report data isn't necessary for realtime, only intermittently, because the values don't
 // change often. The following macros configures how many times a status report needs to be called before
 // the associated data is refreshed and included in the status report. However, if one of these value
@@ -287,6 +342,31 @@
 #define REPORT_WCO_REFRESH_BUSY_COUNT 30  // (2-255)
 #define REPORT_WCO_REFRESH_IDLE_COUNT 10  // (2-255) Must be less than or equal to the busy count
 
+// Enables the '$41' setting, with which Grbl pushes status reports automatically every '$41'
+// milliseconds while running, jogging, or in a feed hold, rather than relying on the host to poll
+// with '?'. A final report is sent upon returning to idle. The options below further reduce the
+// serial traffic of these automatic reports and require this one. The first skips a report entirely,
+// if the machine hasn't moved or changed state since the last report. The second omits the buffer
+// state and feed/speed fields, if unchanged since the last report. Reports requested by '?' are
+// always complete.
+// NOTE: Hosts must not rely on the omitted fields being present in every report, if enabled.
+// #define ENABLE_AUTO_STATUS_REPORT // Default disabled. Uncomment to enable.
+#define DEFAULT_STATUS_REPORT_INTERVAL 0 // msec (0-65535) Zero disables automatic reports.
+// #define REPORT_AUTO_SUPPRESS_UNCHANGED // Default disabled. Uncomment to enable.
+// #define REPORT_AUTO_CHANGED_FIELDS_ONLY // Default disabled. Uncomment to enable.
+
+// Enables velocity jogging with '$JV=X..Y..Z..', where the axis words are signed velocities in
+// mm/min (or inch/min in G20). Grbl jogs along the velocity vector until the host stops sending
+// the same command, sends a zero vector, or a soft limit is reached. Repeats of the same command
+// refresh a watchdog and top up the few planner blocks queued ahead, without the g-code parser,
+// so pendants and joysticks don't need to stream incremental jog lines. A changed vector blends
+// into the new direction and speed from the current speed, like a junction between two jog lines.
+// If not refreshed within the timeout below, the jog is cancelled and decelerates to a stop, as
+// with the jog cancel realtime command.
+// NOTE: Hosts should refresh at least twice per timeout.
+// #define ENABLE_VELOCITY_JOG // Default disabled. Uncomment to enable.
+#define JOG_VELOCITY_TIMEOUT 75 // msec (1-65535)
+
 // The temporal resolution of the acceleration management subsystem. A higher number gives smoother
 // acceleration, particularly noticeable on machines that run at very high feedrates, but may negatively
 // impact performance. The correct value for this parameter is machine dependent, so it's advised to
@@ -459,9 +539,23 @@
 // 115200 baud will take 5 msec to transmit a typical 55 character report. Worst case reports are
 // around 90-100 characters. As long as the serial TX buffer doesn't get continually maxed, Grbl
 // will continue operating efficiently. Size the TX buffer around the size of a worst-case report.
-// #define RX_BUFFER_SIZE 128 // (1-254) Uncomment to override defaults in serial.h
+// NOTE: RX buffers larger than 254 bytes automatically switch to 16-bit ring buffer indices. These
+// are intended for processors with more RAM, like the Mega2560, where 1-4KB RX buffers are feasible.
+// #define RX_BUFFER_SIZE 128 // (1-4096) Uncomment to override defaults in serial.h
 // #define TX_BUFFER_SIZE 100 // (1-254)
 
+// Enables hardware RTS/CTS-style flow control on the serial RX stream. Grbl drives an active-low RTS
+// output pin, defined in cpu_map.h, which should be wired to the CTS input of the host UART or
+// USB-serial bridge. The pin is de-asserted by the RX interrupt when the RX buffer fills up to the high
+// watermark and re-asserted when the main program has read it down to the low watermark. This allows
+// simple streamers, which don't character-count, to send at full link speed without overrunning Grbl.
+// NOTE: The space above the high watermark must absorb any characters the host sends after RTS is
+// de-asserted, which depends on the bridge. Most FTDI and CP210x bridges stop within a few characters.
+// The stock Uno 16U2 and most CH340 firmwares do not support CTS and require an external adapter.
+// #define ENABLE_SERIAL_FLOW_CONTROL // Default disabled. Uncomment to enable.
+#define RX_BUFFER_FLOW_CONTROL_HIGH (RX_BUFFER_SIZE-32) // RX bytes used to stop the host. Must be > low.
+#define RX_BUFFER_FLOW_CONTROL_LOW  (RX_BUFFER_SIZE/2)  // RX bytes used to resume the host.
+
 // A simple software debouncing feature for hard limit switches. When enabled, the interrupt 
 // monitoring the hard limit switch pins will enable the Arduino's watchdog timer to re-check 
 // the limit pin state after a delay of about 32msec. This can help with CNC machines with 
@@ -612,6 +706,29 @@
 #define RPM_LINE_A4  1.203413e-01  // Used N_PIECES = 4. A and B constants of line 4.
 #define RPM_LINE_B4  1.151360e+03
 
+// Replaces the spindle PWM model evaluation for every step segment in laser mode with a lookup table,
+// which is built from the linear or piecewise linear model whenever the settings load or the '$30'
+// and '$31' rpm settings change. The table holds the PWM values at evenly spaced rpm and is indexed
+// with a fixed-point rpm, linearly interpolating between entries. Since both models are linear or
+// piecewise linear, only the few entries spanning a piecewise junction deviate from the model, by
+// a PWM count or two. Most beneficial with the piecewise model and high feed dynamic laser power.
+// NOTE: The table uses SPINDLE_PWM_TABLE_SIZE bytes of RAM. Requires VARIABLE_SPINDLE.
+// #define ENABLE_SPINDLE_PWM_TABLE // Default disabled. Uncomment to enable.
+#define SPINDLE_PWM_TABLE_SIZE 65 // Integer (2-256). Use 256 for one entry per PWM value.
+
+// Enables a compact raster engraving mode for laser images. '$LS=' sets up a scanline: an optional
+// X and Y scanline start in work coordinates, reached with a rapid, the signed X pixel pitch P,
+// the feed rate F, and the full scale power S. Each following '$L=' line carries the power of the
+// next pixels along the scanline, one base32 character '0'-'9','A'-'V' (0-31) per pixel, where '*'
+// followed by a base32 count n repeats the next pixel n+2 times. Each '$L=' line is planned as a single line
+// motion, and the step segment generator ends segments on pixel run boundaries to update the
+// laser power from the payload, just like it does for the dynamic M4 laser power.
+// NOTE: Runs of equal power are merged into one RASTER_BUFFER_SIZE entry (2 bytes of RAM each).
+// The pixel pitch must be at least one X step, and pixels shorter than a few msec at the feed
+// rate may starve the segment buffer. Use doc/script/raster_encode.py to convert images.
+// #define ENABLE_LASER_RASTER // Default disabled. Uncomment to enable.
+#define RASTER_BUFFER_SIZE 48 // Pixel runs (2-255)
+
 /* --------------------------------------------------------------------------------------- 
   This optional dual axis feature is primarily for the homing cycle to locate two sides of 
   a dual-motor gantry independently, i.e. self-squaring. This requires an additional limit
@@ -674,6 +791,19 @@
 // updating lots of code to ensure everything is running correctly.
 // #define DUAL_AXIS_CONFIG_CNC_SHIELD_CLONE  // Uncomment to select. Comment other configs.
 
+// Enables file storage on an external SPI NOR flash chip (W25Q16 or similar). G-code programs are
+// uploaded with '$FU=NAME', closed with '$FC', and run with '$FR=NAME' directly from flash, without a
+// host streaming the lines over the serial port. '$FP' pauses a running file and '$FR' resumes it.
+// Feed hold, cycle start, and soft-reset work as usual.
+// Flash runs report only errors and a feedback message when the file is done or stopped.
+// NOTE: The Uno has no free pins for hardware SPI, so the flash is bit-banged in 3-wire mode on the
+// flood coolant (A3 -> SCK) and spindle direction (D13 -> DI, and DO through a 1k resistor) pins,
+// with chip select on the mist coolant pin (A4). These outputs are disabled. M7 mist coolant, the
+// dual axis feature, serial flow control, and USE_SPINDLE_DIR_AS_ENABLE_PIN are not supported.
+// #define ENABLE_FILE_STORAGE // Default disabled. Uncomment to enable.
+#define STORAGE_FLASH_SIZE 2097152 // Flash chip size in bytes. (2MB W25Q16)
+#define N_STORAGE_FILES 4 // Number of file slots. Flash is divided equally between slots.
+
 
 /* ---------------------------------------------------------------------------------------
    OEM Single File Configuration Option
@@ -96,6 +96,22 @@
   #define PROBE_BIT       5  // Uno Analog Pin 5
   #define PROBE_MASK      (1<<PROBE_BIT)
 
+  // Define serial RTS flow control output pin. Only used when ENABLE_SERIAL_FLOW_CONTROL is enabled.
+  // NOTE: Shares Uno Analog Pin 4 with M7 mist coolant and the dual axis step pin. Select only one.
+  #define FLOW_CONTROL_DDR    DDRC
+  #define FLOW_CONTROL_PORT   PORTC
+  #define FLOW_CONTROL_BIT    4  // Uno Analog Pin 4
+
+  // Define system millisecond tick timer. Shares Timer2 with the variable spindle PWM, which
+  // runs in 8-bit fast PWM mode, and uses its overflow interrupt. The prescaler must match
+  // SPINDLE_TCCRB_INIT_MASK, when variable spindle is enabled.
+  #define SYS_TICK_TCCRB_REGISTER   TCCR2B
+  #define SYS_TICK_TIMSK_REGISTER   TIMSK2
+  #define SYS_TICK_TOIE_BIT         TOIE2
+  #define SYS_TICK_TCCRB_INIT_MASK  (1<<CS22) // 1/64 prescaler -> 1.024 msec overflow
+  #define SYS_TICK_PRESCALER        64
+  #define SYS_TICK_vect             TIMER2_OVF_vect
+
   #if !defined(ENABLE_DUAL_AXIS)
 
     // Define flood and mist coolant enable output pins.
@@ -150,6 +166,29 @@
     #define SPINDLE_PWM_DDR   DDRB
     #define SPINDLE_PWM_PORT  PORTB
     #define SPINDLE_PWM_BIT   3    // Uno Digital Pin 11
+
+    #ifdef ENABLE_FILE_STORAGE
+      // Define 3-wire SPI flash pins. Replaces flood coolant and spindle direction, which are
+      // redirected to unused general purpose I/O register bits to disconnect them.
+      #define STORAGE_CS_DDR    DDRC
+      #define STORAGE_CS_PORT   PORTC
+      #define STORAGE_CS_BIT    4  // Uno Analog Pin 4
+      #define STORAGE_SCK_DDR   DDRC
+      #define STORAGE_SCK_PORT  PORTC
+      #define STORAGE_SCK_BIT   3  // Uno Analog Pin 3
+      #define STORAGE_DIO_DDR   DDRB
+      #define STORAGE_DIO_PORT  PORTB
+      #define STORAGE_DIO_PIN   PINB
+      #define STORAGE_DIO_BIT   5  // Uno Digital Pin 13
+      #undef COOLANT_FLOOD_DDR
+      #undef COOLANT_FLOOD_PORT
+      #define COOLANT_FLOOD_DDR   GPIOR1
+      #define COOLANT_FLOOD_PORT  GPIOR0
+      #undef SPINDLE_DIRECTION_DDR
+      #undef SPINDLE_DIRECTION_PORT
+      #define SPINDLE_DIRECTION_DDR   GPIOR1
+      #define SPINDLE_DIRECTION_PORT  GPIOR0
+    #endif
   
   #else
 
@@ -55,11 +55,14 @@
 #include "print.h"
 #include "probe.h"
 #include "protocol.h"
+#include "line.h"
 #include "report.h"
 #include "serial.h"
 #include "spindle_control.h"
 #include "stepper.h"
 #include "jog.h"
+#include "storage.h"
+#include "raster.h"
 
 // ---------------------------------------------------------------------------------------
 // COMPILE-TIME ERROR CHECKING OF DEFINE VALUES:
@@ -98,6 +101,26 @@
   #endif
 #endif
 
+#if defined(ENABLE_SYSTEM_TICK) && defined(VARIABLE_SPINDLE) && (SPINDLE_TCCRB_INIT_MASK != SYS_TICK_TCCRB_INIT_MASK)
+  #error "Spindle PWM prescaler must match the system tick prescaler. Update SYS_TICK settings in cpu_map.h."
+#endif
+
+#if (RX_BUFFER_SIZE > 4096)
+  #error "RX_BUFFER_SIZE must be 4096 or less."
+#endif
+
+#if defined(ENABLE_SERIAL_FLOW_CONTROL)
+  #if (RX_BUFFER_FLOW_CONTROL_HIGH <= RX_BUFFER_FLOW_CONTROL_LOW)
+    #error "RX_BUFFER_FLOW_CONTROL_HIGH must be greater than RX_BUFFER_FLOW_CONTROL_LOW."
+  #endif
+  #if defined(ENABLE_M7) && defined(CPU_MAP_ATMEGA328P)
+    #error "ENABLE_SERIAL_FLOW_CONTROL shares the M7 mist coolant pin on the Uno. Select only one."
+  #endif
+  #if defined(ENABLE_DUAL_AXIS) && defined(CPU_MAP_ATMEGA328P)
+    #error "ENABLE_SERIAL_FLOW_CONTROL not supported with dual axis feature on the Uno."
+  #endif
+#endif
+
 #if (REPORT_WCO_REFRESH_BUSY_COUNT < REPORT_WCO_REFRESH_IDLE_COUNT)
   #error "WCO busy refresh is less than idle refresh."
 #endif
@@ -135,6 +158,45 @@
   #endif
 #endif
 
+#if defined(ENABLE_SPINDLE_PWM_TABLE) && ((SPINDLE_PWM_TABLE_SIZE < 2) || (SPINDLE_PWM_TABLE_SIZE > 256))
+  #error "SPINDLE_PWM_TABLE_SIZE must be between 2 and 256."
+#endif
+
+#if (defined(REPORT_AUTO_SUPPRESS_UNCHANGED) || defined(REPORT_AUTO_CHANGED_FIELDS_ONLY)) && !defined(ENABLE_AUTO_STATUS_REPORT)
+  #error "REPORT_AUTO_SUPPRESS_UNCHANGED and REPORT_AUTO_CHANGED_FIELDS_ONLY require ENABLE_AUTO_STATUS_REPORT to be enabled."
+#endif
+
+#if defined(REPORT_FIELD_PERF_COUNTERS) && !defined(ENABLE_PERF_COUNTERS)
+  #error "REPORT_FIELD_PERF_COUNTERS requires ENABLE_PERF_COUNTERS to be enabled."
+#endif
+
+#if defined(ENABLE_LASER_RASTER) && !defined(VARIABLE_SPINDLE)
+  #error "ENABLE_LASER_RASTER requires VARIABLE_SPINDLE to be enabled."
+#endif
+
+#if defined(ENABLE_LASER_RASTER) && ((RASTER_BUFFER_SIZE < 2) || (RASTER_BUFFER_SIZE > 255))
+  #error "RASTER_BUFFER_SIZE must be between 2 and 255."
+#endif
+
+#if defined(HOMING_INTERRUPT_LATCH) && defined(ENABLE_DUAL_AXIS)
+  #error "HOMING_INTERRUPT_LATCH not supported with dual axis feature."
+#endif
+
+#if defined(ENABLE_FILE_STORAGE)
+  #if !defined(CPU_MAP_ATMEGA328P)
+    #error "File storage currently supports the Uno (ATmega328p) only."
+  #endif
+  #if defined(ENABLE_DUAL_AXIS) || defined(ENABLE_M7) || defined(ENABLE_SERIAL_FLOW_CONTROL)
+    #error "File storage pins conflict with dual axis, M7 mist coolant, and serial flow control."
+  #endif
+  #if defined(USE_SPINDLE_DIR_AS_ENABLE_PIN)
+    #error "USE_SPINDLE_DIR_AS_ENABLE_PIN not supported with file storage."
+  #endif
+  #if ((STORAGE_FLASH_SIZE/N_STORAGE_FILES) % STORAGE_SECTOR_SIZE)
+    #error "File storage slots must be a multiple of the flash sector size."
+  #endif
+#endif
+
 // ---------------------------------------------------------------------------------------
 
 #endif
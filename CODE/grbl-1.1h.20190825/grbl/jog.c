@@ -48,3 +48,220 @@ uint8_t jog_execute(plan_line_data_t *pl_data, parser_block_t *gc_block)
 
   return(STATUS_OK);
 }
+
+
+#ifdef ENABLE_VELOCITY_JOG
+
+// A velocity jog is queued as a chain of equal blocks along its vector, topped up upon each refresh.
+// The queued blocks always cover the stopping distance, so the jog runs at full speed, and the blocks
+// beyond the stopping distance can be replaced to turn into a new vector without stopping.
+#define JOG_VELOCITY_BLOCKS 4 // Planner blocks kept queued. Less than BLOCK_BUFFER_SIZE-1.
+
+static float jog_velocity[N_AXIS];      // Active velocity jog vector. (mm/min)
+static float jog_unit_vec[N_AXIS];      // Unit vector of the active velocity jog.
+static float jog_target[N_AXIS];        // End of travel along the vector. (mm)
+static float jog_speed;                 // Jog speed along the vector. (mm/min)
+static float jog_block_mm;              // Length of the queued blocks. (mm)
+static float jog_remaining;             // Travel beyond the queued blocks. (mm)
+static uint8_t jog_velocity_state;      // Velocity jog state in the JOG state. See below.
+static uint32_t jog_velocity_refresh;   // Millisecond tick of the last refresh.
+
+#define JOG_VELOCITY_STATE_NONE 0
+#define JOG_VELOCITY_STATE_RUNNING 1
+#define JOG_VELOCITY_STATE_STOPPING 2
+
+
+static void jog_velocity_stop()
+{
+  jog_velocity_state = JOG_VELOCITY_STATE_STOPPING;
+  system_set_exec_state_flag(EXEC_MOTION_CANCEL);
+}
+
+
+// Returns the soft limit travel range of an axis in machine coordinates.
+static void jog_travel_range(uint8_t idx, float *travel_min, float *travel_max)
+{
+  // NOTE: max_travel is stored as negative
+  #ifdef HOMING_FORCE_SET_ORIGIN
+    if (bit_istrue(settings.homing_dir_mask,bit(idx))) {
+      *travel_min = 0.0;
+      *travel_max = -settings.max_travel[idx];
+      return;
+    }
+  #endif
+  *travel_min = settings.max_travel[idx];
+  *travel_max = 0.0;
+}
+
+
+// Sets up a new velocity vector from the end of the queued blocks. The jog travels up to the first
+// soft limit along the vector, or across the full machine travel without soft limits. The target is
+// clamped to the travel range, so rounding can't trigger an alarm.
+static uint8_t jog_velocity_set(float *velocity)
+{
+  memcpy(jog_velocity, velocity, sizeof(jog_velocity));
+  jog_remaining = 0.0;
+  jog_speed = 0.0;
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) { jog_speed += velocity[idx]*velocity[idx]; }
+  jog_speed = sqrt(jog_speed);
+
+  float travel_min, travel_max;
+  float distance = 0.0;
+  plan_get_planner_mpos(jog_target);
+  for (idx=0; idx<N_AXIS; idx++) {
+    jog_unit_vec[idx] = velocity[idx]/jog_speed;
+    distance -= settings.max_travel[idx]; // NOTE: max_travel is stored as negative
+  }
+  if (bit_istrue(settings.flags,BITFLAG_SOFT_LIMIT_ENABLE)) {
+    for (idx=0; idx<N_AXIS; idx++) {
+      jog_travel_range(idx, &travel_min, &travel_max);
+      if (jog_unit_vec[idx] > 0.0) { distance = min(distance, (travel_max-jog_target[idx])/jog_unit_vec[idx]); }
+      else if (jog_unit_vec[idx] < 0.0) { distance = min(distance, (travel_min-jog_target[idx])/jog_unit_vec[idx]); }
+    }
+    if (distance <= 0.0) { return(STATUS_TRAVEL_EXCEEDED); }
+  }
+  for (idx=0; idx<N_AXIS; idx++) {
+    jog_target[idx] += jog_unit_vec[idx]*distance;
+    if (bit_istrue(settings.flags,BITFLAG_SOFT_LIMIT_ENABLE)) {
+      jog_travel_range(idx, &travel_min, &travel_max);
+      jog_target[idx] = max(travel_min, min(travel_max, jog_target[idx]));
+    }
+  }
+  jog_remaining = distance;
+
+  // Size the blocks, so all but the last one cover the stopping distance from the jog speed. Not
+  // shorter than the travel between refreshes, which top the queue up.
+  float acceleration = limit_value_by_axis_maximum(settings.acceleration, jog_unit_vec);
+  jog_block_mm = max( jog_speed*jog_speed/(2*acceleration*(JOG_VELOCITY_BLOCKS-1)),
+                      jog_speed*(JOG_VELOCITY_TIMEOUT/60000.0) );
+  return(STATUS_OK);
+}
+
+
+// Tops up the planner with blocks along the velocity vector, until JOG_VELOCITY_BLOCKS are queued or
+// the end of travel is reached. Spindle and coolant stay in their modal state.
+static void jog_velocity_queue()
+{
+  plan_line_data_t plan_data;
+  memset(&plan_data, 0, sizeof(plan_line_data_t));
+  plan_data.feed_rate = jog_speed;
+  plan_data.spindle_speed = gc_state.spindle_speed;
+  plan_data.condition = (gc_state.modal.spindle | gc_state.modal.coolant | PL_COND_FLAG_NO_FEED_OVERRIDE);
+  #ifdef USE_LINE_NUMBERS
+    plan_data.line_number = JOG_LINE_NUMBER;
+  #endif
+  float target[N_AXIS];
+  uint8_t idx;
+  while ((jog_remaining > 0.0) && (plan_get_block_buffer_count() < JOG_VELOCITY_BLOCKS)) {
+    if (jog_remaining > jog_block_mm) {
+      plan_get_planner_mpos(target);
+      for (idx=0; idx<N_AXIS; idx++) { target[idx] += jog_unit_vec[idx]*jog_block_mm; }
+      jog_remaining -= jog_block_mm;
+    } else {
+      memcpy(target, jog_target, sizeof(target));
+      jog_remaining = 0.0;
+    }
+    mc_line(target, &plan_data);
+    memcpy(gc_state.position, target, sizeof(target));
+  }
+}
+
+
+// Turns the running jog into a new velocity vector. The queued blocks the jog needs to slow down
+// to the junction speed of the new vector are kept, and the rest is replaced by the new vector. The
+// planner then blends both at the junction, continuing from the current speed.
+static uint8_t jog_velocity_blend(float *velocity)
+{
+  float unit_vec[N_AXIS];
+  float speed = 0.0;
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) { speed += velocity[idx]*velocity[idx]; }
+  speed = sqrt(speed);
+  for (idx=0; idx<N_AXIS; idx++) { unit_vec[idx] = velocity[idx]/speed; }
+
+  // The queued blocks, and the last one planned, all run along the current vector.
+  float junction_speed_sqr = plan_compute_junction_speed_sqr(unit_vec);
+  speed = min(speed, limit_value_by_axis_maximum(settings.max_rate, unit_vec));
+  junction_speed_sqr = min(junction_speed_sqr, speed*speed);
+  junction_speed_sqr = min(junction_speed_sqr, jog_speed*jog_speed);
+  float current_speed = st_get_realtime_rate();
+  float keep_distance = 0.0;
+  if (current_speed*current_speed > junction_speed_sqr) {
+    keep_distance = (current_speed*current_speed-junction_speed_sqr)/
+                    (2*limit_value_by_axis_maximum(settings.acceleration, jog_unit_vec));
+  }
+  plan_truncate_buffer(keep_distance);
+  plan_get_planner_mpos(gc_state.position);
+
+  uint8_t status_code = jog_velocity_set(velocity); // The kept blocks finish, if at a soft limit.
+  jog_velocity_queue();
+  return(status_code);
+}
+
+
+// Starts, refreshes, blends, or stops a velocity jog. A jog is kept alive by refreshing with the
+// same vector. A different vector blends into the new direction and speed, while zero stops it.
+uint8_t jog_velocity_execute(char *line)
+{
+  float velocity[N_AXIS];
+  memset(velocity, 0, sizeof(velocity));
+  uint8_t char_counter = 4; // Skip '$JV='
+  uint8_t idx;
+  while (line[char_counter] != 0) {
+    switch (line[char_counter++]) {
+      case 'X': idx = X_AXIS; break;
+      case 'Y': idx = Y_AXIS; break;
+      case 'Z': idx = Z_AXIS; break;
+      default: return(STATUS_INVALID_JOG_COMMAND);
+    }
+    if (!read_float(line, &char_counter, &velocity[idx])) { return(STATUS_BAD_NUMBER_FORMAT); }
+    if (gc_state.modal.units == UNITS_MODE_INCHES) { velocity[idx] *= MM_PER_INCH; }
+  }
+  uint8_t stop = true;
+  for (idx=0; idx<N_AXIS; idx++) {
+    if (velocity[idx] != 0.0) { stop = false; }
+  }
+
+  jog_velocity_watchdog(); // Update velocity jog state, if the jog has ended.
+  if (jog_velocity_state == JOG_VELOCITY_STATE_RUNNING) {
+    jog_velocity_refresh = system_get_millis();
+    if (stop) {
+      jog_velocity_stop();
+      return(STATUS_OK);
+    }
+    if (memcmp(velocity, jog_velocity, sizeof(velocity)) == 0) {
+      jog_velocity_queue();
+      return(STATUS_OK);
+    }
+    return(jog_velocity_blend(velocity));
+  }
+  if (jog_velocity_state == JOG_VELOCITY_STATE_STOPPING) { return(STATUS_OK); } // Ignore until stopped.
+  if (sys.state != STATE_IDLE) { return(STATUS_IDLE_ERROR); }
+  if (stop) { return(STATUS_OK); } // Already stopped.
+
+  uint8_t status_code = jog_velocity_set(velocity);
+  if (status_code != STATUS_OK) { return(status_code); }
+  jog_velocity_queue();
+  if (plan_get_current_block() != NULL) {
+    sys.state = STATE_JOG;
+    st_prep_buffer();
+    st_wake_up();
+    jog_velocity_state = JOG_VELOCITY_STATE_RUNNING;
+    jog_velocity_refresh = system_get_millis();
+  }
+  return(STATUS_OK);
+}
+
+
+void jog_velocity_watchdog()
+{
+  if (jog_velocity_state == JOG_VELOCITY_STATE_NONE) { return; }
+  if (sys.state != STATE_JOG) {
+    jog_velocity_state = JOG_VELOCITY_STATE_NONE; // Stopped, ended at a soft limit, or reset.
+  } else if (jog_velocity_state == JOG_VELOCITY_STATE_RUNNING) {
+    if ((system_get_millis()-jog_velocity_refresh) > JOG_VELOCITY_TIMEOUT) { jog_velocity_stop(); }
+  }
+}
+
+#endif
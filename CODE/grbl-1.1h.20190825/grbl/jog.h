@@ -29,4 +29,12 @@
 // Sets up valid jog motion received from g-code parser, checks for soft-limits, and executes the jog.
 uint8_t jog_execute(plan_line_data_t *pl_data, parser_block_t *gc_block);
 
+#ifdef ENABLE_VELOCITY_JOG
+  // Starts, refreshes, or stops a velocity jog from a '$JV=' command.
+  uint8_t jog_velocity_execute(char *line);
+
+  // Cancels a velocity jog, when it hasn't been refreshed within the timeout.
+  void jog_velocity_watchdog();
+#endif
+
 #endif
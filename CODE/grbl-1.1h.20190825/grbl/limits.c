@@ -30,6 +30,10 @@
   #define HOMING_AXIS_LOCATE_SCALAR  5.0 // Must be > 1 to ensure limit switch is cleared.
 #endif
 
+#ifdef HOMING_INTERRUPT_LATCH
+  static volatile uint8_t homing_latch_mask; // Cycle axes locked by the interrupt. Zero when inactive.
+#endif
+
 #ifdef ENABLE_DUAL_AXIS
   // Flags for dual axis async limit trigger check.
   #define DUAL_AXIS_CHECK_DISABLE     0  // Must be zero
@@ -95,6 +99,29 @@ uint8_t limits_get_state()
 }
 
 
+#ifdef HOMING_INTERRUPT_LATCH
+// Locks the homing cycle axes whose limit switch triggered. Called by the limit pin change interrupt
+// during a homing approach. Clearing the axis lock stops its steps at the next step event, so the
+// axis is halted at the trigger position, rather than after the homing loop polls the switches.
+static void limits_homing_latch()
+{
+  uint8_t limit_state = limits_get_state() & homing_latch_mask;
+  if (limit_state) {
+    uint8_t idx;
+    for (idx=0; idx<N_AXIS; idx++) {
+      if (limit_state & (1 << idx)) {
+        #ifdef COREXY
+          if (idx != Z_AXIS) { sys.homing_axis_lock &= ~(get_step_pin_mask(X_AXIS)|get_step_pin_mask(Y_AXIS)); }
+          else
+        #endif
+        sys.homing_axis_lock &= ~(get_step_pin_mask(idx));
+      }
+    }
+  }
+}
+#endif
+
+
 // This is the Limit Pin Change Interrupt, which handles the hard limit feature. A bouncing
 // limit switch can cause a lot of problems, like false readings and multiple interrupt calls.
 // If a switch is triggered at all, something bad has happened and treat it as such, regardless
@@ -109,6 +136,9 @@ uint8_t limits_get_state()
 #ifndef ENABLE_SOFTWARE_DEBOUNCE
   ISR(LIMIT_INT_vect) // DEFAULT: Limit pin change interrupt process.
   {
+    #ifdef HOMING_INTERRUPT_LATCH
+      if (sys.state == STATE_HOMING) { limits_homing_latch(); return; }
+    #endif
     // Ignore limit switches if already in an alarm state or in-process of executing an alarm.
     // When in the alarm state, Grbl should have been reset or will force a reset, so any pending
     // moves in the planner and serial buffers are all cleared and newly sent blocks will be
@@ -131,7 +161,13 @@ uint8_t limits_get_state()
   }
 #else // OPTIONAL: Software debounce limit pin routine.
   // Upon limit pin change, enable watchdog timer to create a short delay. 
-  ISR(LIMIT_INT_vect) { if (!(WDTCSR & (1<<WDIE))) { WDTCSR |= (1<<WDIE); } }
+  ISR(LIMIT_INT_vect)
+  {
+    #ifdef HOMING_INTERRUPT_LATCH
+      if (sys.state == STATE_HOMING) { limits_homing_latch(); return; } // No debounce. First edge.
+    #endif
+    if (!(WDTCSR & (1<<WDIE))) { WDTCSR |= (1<<WDIE); }
+  }
   ISR(WDT_vect) // Watchdog timer ISR
   {
     WDTCSR &= ~(1<<WDIE); // Disable watchdog timer. 
@@ -264,6 +300,14 @@ void limits_go_home(uint8_t cycle_mask)
     plan_buffer_line(target, pl_data); // Bypass mc_line(). Directly plan homing motion.
 
     sys.step_control = STEP_CONTROL_EXECUTE_SYS_MOTION; // Set to execute homing motion and clear existing flags.
+    #ifdef HOMING_INTERRUPT_LATCH
+      // Latch limit switch triggers by interrupt during approaches. Pull-offs ignore the switches.
+      if (approach) {
+        homing_latch_mask = cycle_mask;
+        LIMIT_PCMSK |= LIMIT_MASK;
+        PCICR |= (1 << LIMIT_INT);
+      }
+    #endif
     st_prep_buffer(); // Prep and fill segment buffer from newly planned block.
     st_wake_up(); // Initiate motion
     do {
@@ -285,7 +329,16 @@ void limits_go_home(uint8_t cycle_mask)
             }
           }
         }
-        sys.homing_axis_lock = axislock;
+        #ifdef HOMING_INTERRUPT_LATCH
+          // Merge with the axes already locked by the interrupt, which may clear bits at any time.
+          uint8_t sreg = SREG;
+          cli();
+          sys.homing_axis_lock &= axislock;
+          axislock = sys.homing_axis_lock;
+          SREG = sreg;
+        #else
+          sys.homing_axis_lock = axislock;
+        #endif
         #ifdef ENABLE_DUAL_AXIS
           if (sys.homing_axis_lock_dual) { // NOTE: Only true when homing dual axis.
             if (limit_state & (1 << N_AXIS)) { 
@@ -345,6 +398,10 @@ void limits_go_home(uint8_t cycle_mask)
       } while (STEP_MASK & axislock);
     #endif
 
+    #ifdef HOMING_INTERRUPT_LATCH
+      limits_disable();
+      homing_latch_mask = 0;
+    #endif
     st_reset(); // Immediately force kill steppers and reset step segment buffer.
     delay_ms(settings.homing_debounce_delay); // Delay to allow transient dynamics to dissipate.
 
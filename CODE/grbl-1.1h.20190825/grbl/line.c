@@ -0,0 +1,83 @@
+/*
+  line.c - line sources and line assembly of the main loop
+  Part of Grbl
+
+  Copyright (c) 2011-2016 Sungeun K. Jeon for Gnea Research LLC
+  Copyright (c) 2009-2011 Simen Svale Skogsrud
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.h"
+
+
+uint8_t line_read(const line_source_t *source, line_reader_t *reader, char *line)
+{
+  uint8_t c;
+  while((c = source->read()) != SERIAL_NO_DATA) {
+    if ((c == '\n') || (c == '\r')) { // End of line reached
+      line[reader->char_counter] = 0; // Set string termination character.
+      return(LINE_COMPLETE);
+    }
+
+    if (reader->mode == LINE_MODE_RAW) {
+      // Keep everything. Pass a full line buffer on as a chunk, and continue the line after it.
+      line[reader->char_counter++] = c;
+      if (reader->char_counter == (LINE_BUFFER_SIZE-1)) {
+        line[reader->char_counter] = 0;
+        reader->char_counter = 0;
+        reader->flags |= LINE_FLAG_CONTINUED;
+        return(LINE_CHUNK);
+      }
+    } else if (reader->flags) {
+      // Throw away all (except EOL) comment characters and overflow characters.
+      if (c == ')') {
+        // End of '()' comment. Resume line allowed.
+        if (reader->flags & LINE_FLAG_COMMENT_PARENTHESES) { reader->flags &= ~(LINE_FLAG_COMMENT_PARENTHESES); }
+      }
+    } else {
+      // Perform an initial filtering by removing spaces and comments and capitalizing all letters.
+      if (c <= ' ') {
+        // Throw away whitepace and control characters
+      } else if (c == '/') {
+        // Block delete NOT SUPPORTED. Ignore character.
+        // NOTE: If supported, would simply need to check the system if block delete is enabled.
+      } else if (c == '(') {
+        // Enable comments flag and ignore all characters until ')' or EOL.
+        // NOTE: This doesn't follow the NIST definition exactly, but is good enough for now.
+        // In the future, we could simply remove the items within the comments, but retain the
+        // comment control characters, so that the g-code parser can error-check it.
+        reader->flags |= LINE_FLAG_COMMENT_PARENTHESES;
+      } else if (c == ';') {
+        // NOTE: ';' comment to EOL is a LinuxCNC definition. Not NIST.
+        reader->flags |= LINE_FLAG_COMMENT_SEMICOLON;
+      // TODO: Install '%' feature
+      // } else if (c == '%') {
+        // Program start-end percent sign NOT SUPPORTED.
+        // NOTE: This maybe installed to tell Grbl when a program is running vs manual input,
+        // where, during a program, the system auto-cycle start will continue to execute
+        // everything until the next '%' sign. This will help fix resuming issues with certain
+        // functions that empty the planner buffer to execute its task on-time.
+      } else if (reader->char_counter >= (LINE_BUFFER_SIZE-1)) {
+        // Detect line buffer overflow and set flag.
+        reader->flags |= LINE_FLAG_OVERFLOW;
+      } else if (c >= 'a' && c <= 'z') { // Upcase lowercase
+        line[reader->char_counter++] = c-'a'+'A';
+      } else {
+        line[reader->char_counter++] = c;
+      }
+    }
+  }
+  return(LINE_INCOMPLETE);
+}
@@ -0,0 +1,57 @@
+/*
+  line.h - line sources and line assembly of the main loop
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef line_h
+#define line_h
+
+
+// Define line flags. Includes comment type tracking and line overflow detection.
+#define LINE_FLAG_OVERFLOW bit(0)
+#define LINE_FLAG_COMMENT_PARENTHESES bit(1)
+#define LINE_FLAG_COMMENT_SEMICOLON bit(2)
+#define LINE_FLAG_CONTINUED bit(3) // Raw mode only. Line follows a chunk of the same line.
+
+// Define line reader modes.
+#define LINE_MODE_GCODE 0 // Removes spaces and comments and capitalizes all letters. Must be zero.
+#define LINE_MODE_RAW   1 // Keeps the characters as received. Only the line end is removed.
+
+// Define line_read() return values.
+#define LINE_INCOMPLETE 0 // Source has no more characters for now. The partial line is kept.
+#define LINE_COMPLETE   1 // Line complete and zero-terminated.
+#define LINE_CHUNK      2 // Raw mode only. Line buffer full with part of a longer line.
+
+// A line source supplies the characters of the lines executed by the main loop, such as the
+// serial port or a file running from storage.
+typedef struct {
+  uint8_t (*read)(); // Returns the next character, or SERIAL_NO_DATA if none is available (yet).
+} line_source_t;
+
+// Tracks the line being assembled. Reset flags and char_counter after a complete line.
+typedef struct {
+  uint8_t mode;         // Line reader mode. See LINE_MODE defines.
+  uint8_t flags;        // See LINE_FLAG defines.
+  uint8_t char_counter; // Characters in the line buffer.
+} line_reader_t;
+
+
+// Reads characters from the source into the line buffer of LINE_BUFFER_SIZE, until a line is
+// complete or the source has no more characters available. A partial line is kept in the buffer
+// and the reader, to be continued from the same source with the next call.
+uint8_t line_read(const line_source_t *source, line_reader_t *reader, char *line);
+
+#endif
@@ -31,6 +31,12 @@ volatile uint8_t sys_rt_exec_state;   // Global realtime executor bitflag variab
 volatile uint8_t sys_rt_exec_alarm;   // Global realtime executor bitflag variable for setting various alarms.
 volatile uint8_t sys_rt_exec_motion_override; // Global realtime executor bitflag variable for motion-based overrides.
 volatile uint8_t sys_rt_exec_accessory_override; // Global realtime executor bitflag variable for spindle/coolant overrides.
+#ifdef ENABLE_BINARY_STATUS_REPORT
+  volatile uint8_t sys_rt_exec_report; // Global realtime executor bitflag variable for additional reports.
+#endif
+#ifdef ENABLE_PERF_COUNTERS
+  volatile perf_t sys_perf; // Runtime performance counters.
+#endif
 #ifdef DEBUG
   volatile uint8_t sys_rt_exec_debug;
 #endif
@@ -41,6 +47,9 @@ int main(void)
   // Initialize system upon power-up.
   serial_init();   // Setup serial baud rate and interrupts
   settings_init(); // Load Grbl settings from EEPROM
+  #ifdef ENABLE_BAUD_RATE_SETTING
+    serial_set_baud_rate(settings.baud_rate); // Switch to the stored baud rate
+  #endif
   stepper_init();  // Configure stepper pins and interrupt timers
   system_init();   // Configure pinout pins and pin-change interrupt
 
@@ -83,6 +92,12 @@ int main(void)
     sys_rt_exec_alarm = 0;
     sys_rt_exec_motion_override = 0;
     sys_rt_exec_accessory_override = 0;
+    #ifdef ENABLE_BINARY_STATUS_REPORT
+      sys_rt_exec_report = 0;
+    #endif
+    #ifdef ENABLE_PERF_COUNTERS
+      memset((void*)&sys_perf,0,sizeof(perf_t)); // Clear performance counters.
+    #endif
 
     // Reset Grbl primary systems.
     serial_reset_read_buffer(); // Clear serial read buffer
@@ -91,6 +106,9 @@ int main(void)
     coolant_init();
     limits_init();
     probe_init();
+    #ifdef ENABLE_FILE_STORAGE
+      storage_init(); // Stop any file upload or run.
+    #endif
     plan_reset(); // Clear block buffer and planner variables
     st_reset(); // Clear stepper subsystem variables.
 
@@ -22,11 +22,15 @@
 #include "grbl.h"
 
 
+static void mc_buffer_line(float *target, plan_line_data_t *pl_data);
+
+
 // Execute linear motion in absolute millimeter coordinates. Feed rate given in millimeters/second
 // unless invert_feed_rate is true. Then the feed_rate means that the motion should be completed in
 // (1 minute)/feed_rate time.
-// NOTE: This is the primary gateway to the grbl planner. All line motions, including arc line
-// segments, must pass through this routine before being passed to the planner. The seperation of
+// NOTE: This is the primary gateway to the grbl planner. All line motions, except arc line segments,
+// must pass through this routine before being passed to the planner. mc_arc() checks the whole arc
+// against the soft limits up front and queues its segments with mc_buffer_line(). The seperation of
 // mc_line and plan_buffer_line is done primarily to place non-planner-type functions from being
 // in the planner and to let backlash compensation or canned cycle integration simple and direct.
 void mc_line(float *target, plan_line_data_t *pl_data)
@@ -37,10 +41,27 @@ void mc_line(float *target, plan_line_data_t *pl_data)
     // NOTE: Block jog state. Jogging is a special case and soft limits are handled independently.
     if (sys.state != STATE_JOG) { limits_soft_check(target); }
   }
+  mc_buffer_line(target, pl_data);
+}
 
+
+// Queues a line motion into the planner buffer without a soft limit check. Used by mc_line() and
+// by mc_arc(), which checks the whole arc up front instead of each of its segments.
+static void mc_buffer_line(float *target, plan_line_data_t *pl_data)
+{
   // If in check gcode mode, prevent motion by blocking planner. Soft limits still work.
   if (sys.state == STATE_CHECK_MODE) { return; }
 
+  #ifdef SPINDLE_SPINUP_OVERLAP
+    // Hold feed motions until the spindle is up to speed. Rapids may move during the spin-up, and so
+    // may jogs and probe cycles, which don't cut and are the motions without feed override.
+    // NOTE: With ALLOW_FEED_OVERRIDE_DURING_PROBE_CYCLES, probe cycles wait for the spin-up as well.
+    if (bit_isfalse(pl_data->condition,(PL_COND_FLAG_RAPID_MOTION|PL_COND_FLAG_NO_FEED_OVERRIDE))) {
+      spindle_spinup_synchronize();
+      if (sys.abort) { return; } // Bail, if system abort.
+    }
+  #endif
+
   // NOTE: Backlash compensation may be installed here. It will need direction info to track when
   // to insert a backlash line motion(s) before the intended line motion and will require its own
   // plan_check_full_buffer() and check for system abort loop. Also for position reporting
@@ -77,6 +98,19 @@ void mc_line(float *target, plan_line_data_t *pl_data)
 }
 
 
+// Returns the quadrant of a radius vector, where quadrant n spans the angles [n*90,(n+1)*90) degrees.
+static uint8_t mc_arc_quadrant(float r_axis0, float r_axis1)
+{
+  if (r_axis1 >= 0.0) {
+    if (r_axis0 > 0.0) { return(0); }
+    if (r_axis1 > 0.0) { return(1); }
+    return(2);
+  }
+  if (r_axis0 >= 0.0) { return(3); }
+  return(2);
+}
+
+
 // Execute an arc in offset mode format. position == current xyz, target == target xyz,
 // offset == offset from current xyz, axis_X defines circle plane in tool space, axis_linear is
 // the direction of helical travel, radius == circle radius, isclockwise boolean. Used
@@ -102,6 +136,36 @@ void mc_arc(float *target, plan_line_data_t *pl_data, float *position, float *of
     if (angular_travel <= ARC_ANGULAR_TRAVEL_EPSILON) { angular_travel += 2*M_PI; }
   }
 
+  // If enabled, check the whole arc against the soft limits once, rather than each segment. The
+  // axis-aligned bounding box spans the start and end points, plus each circle extreme the arc
+  // sweeps through. These are found without trig from the quadrants of the start and end radius
+  // vectors, since the arc crosses an axis direction with each quadrant boundary.
+  if (bit_istrue(settings.flags,BITFLAG_SOFT_LIMIT_ENABLE)) {
+    float arc_min[N_AXIS], arc_max[N_AXIS];
+    uint8_t idx;
+    for (idx=0; idx<N_AXIS; idx++) {
+      arc_min[idx] = min(position[idx], target[idx]);
+      arc_max[idx] = max(position[idx], target[idx]);
+    }
+    uint8_t quadrant = mc_arc_quadrant(r_axis0, r_axis1);
+    uint8_t n_crossings = (mc_arc_quadrant(rt_axis0, rt_axis1)-quadrant) & 3;
+    if (is_clockwise_arc) { n_crossings = (-n_crossings) & 3; }
+    if ((n_crossings == 0) && (fabs(angular_travel) > M_PI)) { n_crossings = 4; } // Near or full circle.
+    while (n_crossings--) {
+      if (!is_clockwise_arc) { quadrant++; } // CCW crosses the upper boundary, CW the lower.
+      switch (quadrant & 3) {
+        case 0: arc_max[axis_0] = center_axis0 + radius; break;
+        case 1: arc_max[axis_1] = center_axis1 + radius; break;
+        case 2: arc_min[axis_0] = center_axis0 - radius; break;
+        default: arc_min[axis_1] = center_axis1 - radius; break;
+      }
+      if (is_clockwise_arc) { quadrant--; }
+    }
+    // Raise the soft limit alarm before any segment is queued.
+    if (system_check_travel_limits(arc_min)) { limits_soft_check(arc_min); return; }
+    if (system_check_travel_limits(arc_max)) { limits_soft_check(arc_max); return; }
+  }
+
   // NOTE: Segment end points are on the arc, which can lead to the arc diameter being smaller by up to
   // (2x) settings.arc_tolerance. For 99% of users, this is just fine. If a different arc segment fit
   // is desired, i.e. least-squares, midpoint on arc, just change the mm_per_arc_segment calculation.
@@ -180,14 +244,14 @@ void mc_arc(float *target, plan_line_data_t *pl_data, float *position, float *of
       position[axis_1] = center_axis1 + r_axis1;
       position[axis_linear] += linear_per_segment;
 
-      mc_line(position, pl_data);
+      mc_buffer_line(position, pl_data);
 
       // Bail mid-circle on system abort. Runtime command check already performed by mc_line.
       if (sys.abort) { return; }
     }
   }
   // Ensure last segment arrives at target location.
-  mc_line(target, pl_data);
+  mc_buffer_line(target, pl_data);
 }
 
 
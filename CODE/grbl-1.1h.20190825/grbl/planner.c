@@ -209,6 +209,9 @@ void plan_reset_buffer()
   block_buffer_head = 0; // Empty = tail
   next_buffer_head = 1; // plan_next_block_index(block_buffer_head)
   block_buffer_planned = 0; // = block_buffer_tail;
+  #ifdef ENABLE_LASER_RASTER
+    raster_reset(); // Raster runs belong to the discarded blocks.
+  #endif
 }
 
 
@@ -219,6 +222,9 @@ void plan_discard_current_block()
     // Push block_buffer_planned pointer, if encountered.
     if (block_buffer_tail == block_buffer_planned) { block_buffer_planned = block_index; }
     block_buffer_tail = block_index;
+    #ifdef ENABLE_PERF_COUNTERS
+      if (block_buffer_tail == block_buffer_head) { sys_perf.planner_empty++; }
+    #endif
   }
 }
 
@@ -254,14 +260,28 @@ uint8_t plan_check_full_buffer()
 }
 
 
-// Computes and returns block nominal speed based on running condition and override values.
-// NOTE: All system motion commands, such as homing/parking, are not subject to overrides.
-float plan_compute_profile_nominal_speed(plan_block_t *block)
+#ifdef SPINDLE_SPINUP_OVERLAP
+  // Returns true, if the block ring buffer holds only rapid motions or nothing.
+  uint8_t plan_check_rapid_buffer()
+  {
+    uint8_t block_index = block_buffer_tail;
+    while (block_index != block_buffer_head) {
+      if (bit_isfalse(block_buffer[block_index].condition,PL_COND_FLAG_RAPID_MOTION)) { return(false); }
+      block_index = plan_next_block_index(block_index);
+    }
+    return(true);
+  }
+#endif
+
+
+// Computes and returns block nominal speed based on running condition and the given override
+// scaling factors, so callers updating many blocks only need to compute them once.
+static float plan_compute_nominal_speed(plan_block_t *block, float feed_scale, float rapid_scale)
 {
   float nominal_speed = block->programmed_rate;
-  if (block->condition & PL_COND_FLAG_RAPID_MOTION) { nominal_speed *= (0.01*sys.r_override); }
+  if (block->condition & PL_COND_FLAG_RAPID_MOTION) { nominal_speed *= rapid_scale; }
   else {
-    if (!(block->condition & PL_COND_FLAG_NO_FEED_OVERRIDE)) { nominal_speed *= (0.01*sys.f_override); }
+    if (!(block->condition & PL_COND_FLAG_NO_FEED_OVERRIDE)) { nominal_speed *= feed_scale; }
     if (nominal_speed > block->rapid_rate) { nominal_speed = block->rapid_rate; }
   }
   if (nominal_speed > MINIMUM_FEED_RATE) { return(nominal_speed); }
@@ -269,6 +289,17 @@ float plan_compute_profile_nominal_speed(plan_block_t *block)
 }
 
 
+// Computes and returns block nominal speed based on running condition and override values.
+// NOTE: All system motion commands, such as homing/parking, are not subject to overrides.
+float plan_compute_profile_nominal_speed(plan_block_t *block)
+{
+  if (block->condition & PL_COND_FLAG_RAPID_MOTION) {
+    return(plan_compute_nominal_speed(block, 1.0, 0.01*sys.r_override));
+  }
+  return(plan_compute_nominal_speed(block, 0.01*sys.f_override, 1.0));
+}
+
+
 // Computes and updates the max entry speed (sqr) of the block, based on the minimum of the junction's
 // previous and current nominal speeds and max junction speed.
 static void plan_compute_profile_parameters(plan_block_t *block, float nominal_speed, float prev_nominal_speed)
@@ -280,21 +311,82 @@ static void plan_compute_profile_parameters(plan_block_t *block, float nominal_s
 }
 
 
-// Re-calculates buffered motions profile parameters upon a motion-based override change.
-void plan_update_velocity_profile_parameters()
+// Re-calculates buffered motions profile parameters upon a motion-based override change. Returns
+// true, if the max entry speed of any block after the executing one changed and the buffer must be
+// replanned. Otherwise, the existing plan remains valid, since the planner passes only depend on
+// the max entry speeds, and only the executing block needs its velocity profile recomputed. This
+// is often the case, such as a rapid override change while cutting or when junction speeds limit.
+uint8_t plan_update_velocity_profile_parameters()
 {
   uint8_t block_index = block_buffer_tail;
   plan_block_t *block;
+  float feed_scale = 0.01*sys.f_override;
+  float rapid_scale = 0.01*sys.r_override;
   float nominal_speed;
+  float max_entry_speed_sqr;
   float prev_nominal_speed = SOME_LARGE_VALUE; // Set high for first block nominal speed calculation.
+  uint8_t replan = false;
   while (block_index != block_buffer_head) {
     block = &block_buffer[block_index];
-    nominal_speed = plan_compute_profile_nominal_speed(block);
+    nominal_speed = plan_compute_nominal_speed(block, feed_scale, rapid_scale);
+    max_entry_speed_sqr = block->max_entry_speed_sqr;
     plan_compute_profile_parameters(block, nominal_speed, prev_nominal_speed);
+    // NOTE: The executing block entry speed is set by the stepper and is not replanned.
+    if ((block_index != block_buffer_tail) && (block->max_entry_speed_sqr != max_entry_speed_sqr)) { replan = true; }
     prev_nominal_speed = nominal_speed;
     block_index = plan_next_block_index(block_index);
   }
   pl.previous_nominal_speed = prev_nominal_speed; // Update prev nominal speed for next incoming block.
+  return(replan);
+}
+
+
+/* Computes the maximum allowable entry speed (sqr) at the junction of the last block in the buffer
+   and a new line along unit_vec, by centripetal acceleration approximation.
+   Let a circle be tangent to both previous and current path line segments, where the junction
+   deviation is defined as the distance from the junction to the closest edge of the circle,
+   colinear with the circle center. The circular segment joining the two paths represents the
+   path of centripetal acceleration. Solve for max velocity based on max acceleration about the
+   radius of the circle, defined indirectly by junction deviation. This may be also viewed as
+   path width or max_jerk in the previous Grbl version. This approach does not actually deviate
+   from path, but used as a robust way to compute cornering speeds, as it takes into account the
+   nonlinearities of both the junction angle and junction velocity.
+
+   NOTE: If the junction deviation value is finite, Grbl executes the motions in an exact path
+   mode (G61). If the junction deviation value is zero, Grbl will execute the motion in an exact
+   stop mode (G61.1) manner. In the future, if continuous mode (G64) is desired, the math here
+   is exactly the same. Instead of motioning all the way to junction point, the machine will
+   just follow the arc circle defined here. The Arduino doesn't have the CPU cycles to perform
+   a continuous mode path, but ARM-based microcontrollers most certainly do.
+
+   NOTE: The max junction speed is a fixed value, since machine acceleration limits cannot be
+   changed dynamically during operation nor can the line move geometry. This must be kept in
+   memory in the event of a feedrate override changing the nominal speeds of blocks, which can
+   change the overall maximum entry speed conditions of all blocks. */
+float plan_compute_junction_speed_sqr(float *unit_vec)
+{
+  float junction_unit_vec[N_AXIS];
+  float junction_cos_theta = 0.0;
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    junction_cos_theta -= pl.previous_unit_vec[idx]*unit_vec[idx];
+    junction_unit_vec[idx] = unit_vec[idx]-pl.previous_unit_vec[idx];
+  }
+
+  // NOTE: Computed without any expensive trig, sin() or acos(), by trig half angle identity of cos(theta).
+  if (junction_cos_theta > 0.999999) {
+    //  For a 0 degree acute junction, just set minimum junction speed.
+    return(MINIMUM_JUNCTION_SPEED*MINIMUM_JUNCTION_SPEED);
+  }
+  if (junction_cos_theta < -0.999999) {
+    // Junction is a straight line or 180 degrees. Junction speed is infinite.
+    return(SOME_LARGE_VALUE);
+  }
+  convert_delta_vector_to_unit_vector(junction_unit_vec);
+  float junction_acceleration = limit_value_by_axis_maximum(settings.acceleration, junction_unit_vec);
+  float sin_theta_d2 = sqrt(0.5*(1.0-junction_cos_theta)); // Trig half angle identity. Always positive.
+  return(max( MINIMUM_JUNCTION_SPEED*MINIMUM_JUNCTION_SPEED,
+              (junction_acceleration * settings.junction_deviation * sin_theta_d2)/(1.0-sin_theta_d2) ));
 }
 
 
@@ -324,6 +416,9 @@ uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
   #ifdef USE_LINE_NUMBERS
     block->line_number = pl_data->line_number;
   #endif
+  #ifdef ENABLE_LASER_RASTER
+    block->raster_pixels = pl_data->raster_pixels;
+  #endif
 
   // Compute and store initial move distance data.
   int32_t target_steps[N_AXIS], position_steps[N_AXIS];
@@ -378,7 +473,12 @@ uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
   }
 
   // Bail if this is a zero-length block. Highly unlikely to occur.
-  if (block->step_event_count == 0) { return(PLAN_EMPTY_BLOCK); }
+  if (block->step_event_count == 0) {
+    #ifdef ENABLE_PERF_COUNTERS
+      sys_perf.rejected++;
+    #endif
+    return(PLAN_EMPTY_BLOCK);
+  }
 
   // Calculate the unit vector of the line move and the block maximum feed rate and acceleration scaled
   // down such that no individual axes maximum values are exceeded with respect to the line direction.
@@ -404,51 +504,7 @@ uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
     block->max_junction_speed_sqr = 0.0; // Starting from rest. Enforce start from zero velocity.
 
   } else {
-    // Compute maximum allowable entry speed at junction by centripetal acceleration approximation.
-    // Let a circle be tangent to both previous and current path line segments, where the junction
-    // deviation is defined as the distance from the junction to the closest edge of the circle,
-    // colinear with the circle center. The circular segment joining the two paths represents the
-    // path of centripetal acceleration. Solve for max velocity based on max acceleration about the
-    // radius of the circle, defined indirectly by junction deviation. This may be also viewed as
-    // path width or max_jerk in the previous Grbl version. This approach does not actually deviate
-    // from path, but used as a robust way to compute cornering speeds, as it takes into account the
-    // nonlinearities of both the junction angle and junction velocity.
-    //
-    // NOTE: If the junction deviation value is finite, Grbl executes the motions in an exact path
-    // mode (G61). If the junction deviation value is zero, Grbl will execute the motion in an exact
-    // stop mode (G61.1) manner. In the future, if continuous mode (G64) is desired, the math here
-    // is exactly the same. Instead of motioning all the way to junction point, the machine will
-    // just follow the arc circle defined here. The Arduino doesn't have the CPU cycles to perform
-    // a continuous mode path, but ARM-based microcontrollers most certainly do.
-    //
-    // NOTE: The max junction speed is a fixed value, since machine acceleration limits cannot be
-    // changed dynamically during operation nor can the line move geometry. This must be kept in
-    // memory in the event of a feedrate override changing the nominal speeds of blocks, which can
-    // change the overall maximum entry speed conditions of all blocks.
-
-    float junction_unit_vec[N_AXIS];
-    float junction_cos_theta = 0.0;
-    for (idx=0; idx<N_AXIS; idx++) {
-      junction_cos_theta -= pl.previous_unit_vec[idx]*unit_vec[idx];
-      junction_unit_vec[idx] = unit_vec[idx]-pl.previous_unit_vec[idx];
-    }
-
-    // NOTE: Computed without any expensive trig, sin() or acos(), by trig half angle identity of cos(theta).
-    if (junction_cos_theta > 0.999999) {
-      //  For a 0 degree acute junction, just set minimum junction speed.
-      block->max_junction_speed_sqr = MINIMUM_JUNCTION_SPEED*MINIMUM_JUNCTION_SPEED;
-    } else {
-      if (junction_cos_theta < -0.999999) {
-        // Junction is a straight line or 180 degrees. Junction speed is infinite.
-        block->max_junction_speed_sqr = SOME_LARGE_VALUE;
-      } else {
-        convert_delta_vector_to_unit_vector(junction_unit_vec);
-        float junction_acceleration = limit_value_by_axis_maximum(settings.acceleration, junction_unit_vec);
-        float sin_theta_d2 = sqrt(0.5*(1.0-junction_cos_theta)); // Trig half angle identity. Always positive.
-        block->max_junction_speed_sqr = max( MINIMUM_JUNCTION_SPEED*MINIMUM_JUNCTION_SPEED,
-                       (junction_acceleration * settings.junction_deviation * sin_theta_d2)/(1.0-sin_theta_d2) );
-      }
-    }
+    block->max_junction_speed_sqr = plan_compute_junction_speed_sqr(unit_vec);
   }
 
   // Block system motion from updating this data to ensure next g-code motion is computed correctly.
@@ -494,6 +550,14 @@ void plan_sync_position()
 }
 
 
+// Returns the planner position in machine coordinates, i.e. the end of the last block in the buffer.
+void plan_get_planner_mpos(float *target)
+{
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) { target[idx] = pl.position[idx]/settings.steps_per_mm[idx]; }
+}
+
+
 // Returns the number of available blocks are in the planner buffer.
 uint8_t plan_get_block_buffer_available()
 {
@@ -511,6 +575,77 @@ uint8_t plan_get_block_buffer_count()
 }
 
 
+#ifdef ENABLE_VELOCITY_JOG
+// Computes the signed travel of a block in cartesian steps. Under COREXY, block steps are A and B
+// motor steps and are converted back to X and Y.
+static void plan_get_block_delta_steps(plan_block_t *block, int32_t *delta_steps)
+{
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    delta_steps[idx] = block->steps[idx];
+    if (block->direction_bits & get_direction_pin_mask(idx)) { delta_steps[idx] = -delta_steps[idx]; }
+  }
+  #ifdef COREXY
+    int32_t a_steps = delta_steps[A_MOTOR];
+    delta_steps[X_AXIS] = (a_steps+delta_steps[B_MOTOR])/2;
+    delta_steps[Y_AXIS] = (a_steps-delta_steps[B_MOTOR])/2;
+  #endif
+}
+
+
+// Discards the blocks queued behind the executing one, except those needed to cover the given
+// distance from the current point of execution, and replans the kept blocks to end at a stop. The
+// planner position and previous block data are rolled back to the end of the last kept block, so a
+// new block continues from there at the junction speed. Used by velocity jogs to change direction
+// without stopping.
+// NOTE: Discarded blocks must not have raster runs.
+void plan_truncate_buffer(float distance)
+{
+  uint8_t block_index = block_buffer_tail;
+  if (block_index == block_buffer_head) { return; } // Buffer empty.
+  plan_block_t *block;
+  float millimeters = 0.0;
+  do {
+    block = &block_buffer[block_index];
+    millimeters += block->millimeters; // Remaining distance of the executing block.
+    block_index = plan_next_block_index(block_index);
+  } while ((block_index != block_buffer_head) && (millimeters < distance));
+
+  // Roll back the planner position by the discarded blocks.
+  int32_t delta_steps[N_AXIS];
+  uint8_t idx;
+  while (block_buffer_head != block_index) {
+    block_buffer_head = plan_prev_block_index(block_buffer_head);
+    plan_get_block_delta_steps(&block_buffer[block_buffer_head],delta_steps);
+    for (idx=0; idx<N_AXIS; idx++) { pl.position[idx] -= delta_steps[idx]; }
+  }
+  next_buffer_head = plan_next_block_index(block_buffer_head);
+
+  // Continue from the direction and nominal speed of the last kept block, as plan_buffer_line()
+  // computed them. Its unit vector is rebuilt from the cartesian travel the same way, which under
+  // COREXY is in A and B motor space.
+  plan_get_block_delta_steps(block,delta_steps);
+  for (idx=0; idx<N_AXIS; idx++) {
+    #ifdef COREXY
+      if (idx == A_MOTOR) {
+        pl.previous_unit_vec[idx] = (delta_steps[X_AXIS]+delta_steps[Y_AXIS])/settings.steps_per_mm[idx];
+      } else if (idx == B_MOTOR) {
+        pl.previous_unit_vec[idx] = (delta_steps[X_AXIS]-delta_steps[Y_AXIS])/settings.steps_per_mm[idx];
+      } else {
+        pl.previous_unit_vec[idx] = delta_steps[idx]/settings.steps_per_mm[idx];
+      }
+    #else
+      pl.previous_unit_vec[idx] = delta_steps[idx]/settings.steps_per_mm[idx];
+    #endif
+  }
+  convert_delta_vector_to_unit_vector(pl.previous_unit_vec);
+  pl.previous_nominal_speed = plan_compute_profile_nominal_speed(block);
+
+  plan_cycle_reinitialize(); // Replan from the current speed of the executing block.
+}
+#endif
+
+
 // Re-initialize buffer plan with a partially completed block, assumed to exist at the buffer tail.
 // Called after a steppers have come to a complete stop for a feed hold and the cycle is stopped.
 void plan_cycle_reinitialize()
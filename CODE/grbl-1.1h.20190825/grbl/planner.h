@@ -83,6 +83,9 @@ typedef struct {
     // Stored spindle speed data used by spindle overrides and resuming methods.
     float spindle_speed;    // Block spindle speed. Copied from pl_line_data.
   #endif
+  #ifdef ENABLE_LASER_RASTER
+    uint16_t raster_pixels; // Raster pixels along the block. Zero, if not a raster block.
+  #endif
 } plan_block_t;
 
 
@@ -94,6 +97,9 @@ typedef struct {
   #ifdef USE_LINE_NUMBERS
     int32_t line_number;    // Desired line number to report when executing.
   #endif
+  #ifdef ENABLE_LASER_RASTER
+    uint16_t raster_pixels; // Raster pixels along the line. Power runs are in the raster buffer.
+  #endif
 } plan_line_data_t;
 
 
@@ -125,8 +131,9 @@ float plan_get_exec_block_exit_speed_sqr();
 // Called by main program during planner calculations and step segment buffer during initialization.
 float plan_compute_profile_nominal_speed(plan_block_t *block);
 
-// Re-calculates buffered motions profile parameters upon a motion-based override change.
-void plan_update_velocity_profile_parameters();
+// Re-calculates buffered motions profile parameters upon a motion-based override change. Returns
+// true, if the buffer must be replanned.
+uint8_t plan_update_velocity_profile_parameters();
 
 // Reset the planner position vector (in steps)
 void plan_sync_position();
@@ -134,6 +141,14 @@ void plan_sync_position();
 // Reinitialize plan with a partially completed block
 void plan_cycle_reinitialize();
 
+// Returns the maximum junction speed (sqr) of a new line along unit_vec after the last block.
+float plan_compute_junction_speed_sqr(float *unit_vec);
+
+#ifdef ENABLE_VELOCITY_JOG
+  // Discards queued blocks beyond the given distance and replans the rest to end at a stop.
+  void plan_truncate_buffer(float distance);
+#endif
+
 // Returns the number of available blocks are in the planner buffer.
 uint8_t plan_get_block_buffer_available();
 
@@ -144,6 +159,12 @@ uint8_t plan_get_block_buffer_count();
 // Returns the status of the block ring buffer. True, if buffer is full.
 uint8_t plan_check_full_buffer();
 
+#ifdef SPINDLE_SPINUP_OVERLAP
+  // Returns true, if the block ring buffer holds no feed motions. It may still hold rapids.
+  uint8_t plan_check_rapid_buffer();
+#endif
+
+// Returns the planner position in machine coordinates.
 void plan_get_planner_mpos(float *target);
 
 
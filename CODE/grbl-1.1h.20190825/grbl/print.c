@@ -144,14 +144,27 @@ void printFloat(float n, uint8_t decimal_places)
   }
   if (decimals) { n *= 10; }
   n += 0.5; // Add rounding factor. Ensures carryover through entire value.
+  printFixed((long)n,decimal_places);
+}
+
 
+// Prints an unsigned fixed-point value, i.e. n/10^decimal_places, with all digits generated by
+// integer operations. Switches to 16-bit division as soon as the remaining value fits, which is
+// several times faster than 32-bit division on the AVR.
+void printFixed(uint32_t n, uint8_t decimal_places)
+{
   // Generate digits backwards and store in string.
   unsigned char buf[13];
   uint8_t i = 0;
-  uint32_t a = (long)n;
-  while(a > 0) {
-    buf[i++] = (a % 10) + '0'; // Get digit
-    a /= 10;
+  while (n > 0xFFFF) {
+    uint32_t q = n/10;
+    buf[i++] = (n - 10*q) + '0'; // Get digit
+    n = q;
+  }
+  uint16_t b = n;
+  while(b > 0) {
+    buf[i++] = (b % 10) + '0'; // Get digit
+    b /= 10;
   }
   while (i < decimal_places) {
      buf[i++] = '0'; // Fill in zeros to decimal point for (n < 1)
@@ -168,6 +181,68 @@ void printFloat(float n, uint8_t decimal_places)
 }
 
 
+#ifdef REPORT_POSITION_FIXED_POINT
+// Sets up the fixed-point conversion of an axis from machine steps to reported coordinate counts,
+// i.e. thousandths of mm or ten-thousandths of inches. The scale is normalized to 31 bits, which
+// resolves it far better than the float math of printFloat_CoordValue(). Called upon steps/mm or
+// report inches changes only.
+void printCoord_SetScale(coord_steps_t *coord, float steps_per_mm)
+{
+  float counts_per_step;
+  if (bit_istrue(settings.flags,BITFLAG_REPORT_INCHES)) {
+    coord->decimals = N_DECIMAL_COORDVALUE_INCH;
+    coord->counts_per_mm = INCH_PER_MM*10000.0;
+  } else {
+    coord->decimals = N_DECIMAL_COORDVALUE_MM;
+    coord->counts_per_mm = 1000.0;
+  }
+  coord->steps_per_mm = steps_per_mm;
+  counts_per_step = coord->counts_per_mm/steps_per_mm;
+  int exponent;
+  frexp(counts_per_step,&exponent);
+  if (exponent > 31) { exponent = 31; } // Beyond any sane steps/mm. Keeps shift > 0.
+  coord->shift = 31-exponent;
+  coord->scale = ldexp(counts_per_step,coord->shift);
+  coord->offset = 0.0;
+  coord->offset_fp = 0;
+}
+
+
+// Prints a machine step position, less a work coordinate offset in mm, as coordinate value. Prints
+// exactly what printFloat_CoordValue(steps/steps_per_mm-offset) prints, but the usual case takes
+// only a 32x32-bit multiply and integer operations. The fixed-point offset is only recomputed, when
+// the offset changes. Values within the float rounding error of printFloat_CoordValue() from a
+// rounding boundary, where its rounding noise decides the last digit, are passed on to it. These
+// are mostly exact half counts, e.g. odd steps at 80 steps/mm. See test/test_print.c.
+void printCoord_Steps(coord_steps_t *coord, int32_t steps, float offset)
+{
+  if (offset != coord->offset) {
+    coord->offset = offset;
+    coord->offset_fp = ldexp(offset*coord->counts_per_mm,coord->shift);
+  }
+  int64_t q = (int64_t)steps*coord->scale;
+  // The float path rounds each of its operations to 24 bits. The error relative to the magnitudes
+  // involved stays below 2^-21, which the tests confirm over the full travel.
+  uint64_t margin = ((uint64_t)(q < 0 ? -q : q) >> 21) + 2;
+  margin += (uint64_t)(coord->offset_fp < 0 ? -coord->offset_fp : coord->offset_fp) >> 21;
+  q -= coord->offset_fp;
+
+  uint8_t is_negative = (q < 0);
+  uint64_t n = (is_negative ? -q : q);
+  uint64_t half = (uint64_t)1 << (coord->shift-1);
+  uint64_t fraction = n & ((half << 1)-1);
+  if ((n <= margin) || ((fraction > half ? fraction-half : half-fraction) <= margin)) {
+    float mpos = steps/coord->steps_per_mm; // Same as system_convert_axis_steps_to_mpos().
+    mpos -= offset;
+    printFloat_CoordValue(mpos);
+    return;
+  }
+  if (is_negative) { serial_write('-'); }
+  printFixed((n+half) >> coord->shift,coord->decimals);
+}
+#endif
+
+
 // Floating value printing handlers for special variables types used in Grbl and are defined
 // in the config.h.
 //  - CoordValue: Handles all position or coordinate values in inches or mm reporting.
@@ -39,6 +39,28 @@ void print_uint8_base2_ndigit(uint8_t n, uint8_t digits);
 
 void printFloat(float n, uint8_t decimal_places);
 
+// Prints an unsigned fixed-point value with the given number of decimal places.
+void printFixed(uint32_t n, uint8_t decimal_places);
+
+#ifdef REPORT_POSITION_FIXED_POINT
+// Define fixed-point conversion of an axis from machine steps to reported coordinate values.
+typedef struct {
+  int32_t scale;        // Reported counts per step, times 2^shift.
+  uint8_t shift;
+  uint8_t decimals;
+  float counts_per_mm;
+  float steps_per_mm;
+  float offset;         // Offset in mm, which offset_fp was computed for.
+  int64_t offset_fp;    // Offset in reported counts, times 2^shift.
+} coord_steps_t;
+
+// Sets up the step conversion of an axis. Call upon steps/mm or report inches changes.
+void printCoord_SetScale(coord_steps_t *coord, float steps_per_mm);
+
+// Prints a step position, less an offset in mm, exactly as printFloat_CoordValue() would.
+void printCoord_Steps(coord_steps_t *coord, int32_t steps, float offset);
+#endif
+
 // Floating value printing handlers for special variables types used in Grbl.
 //  - CoordValue: Handles all position or coordinate values in inches or mm reporting.
 //  - RateValue: Handles feed rate and current velocity in inches or mm reporting.
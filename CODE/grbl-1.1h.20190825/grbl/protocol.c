@@ -21,15 +21,134 @@
 
 #include "grbl.h"
 
-// Define line flags. Includes comment type tracking and line overflow detection.
-#define LINE_FLAG_OVERFLOW bit(0)
-#define LINE_FLAG_COMMENT_PARENTHESES bit(1)
-#define LINE_FLAG_COMMENT_SEMICOLON bit(2)
-
-
 static char line[LINE_BUFFER_SIZE]; // Line to be executed. Zero-terminated.
+#ifdef ENABLE_FILE_STORAGE
+  static uint8_t upload_status; // First failure among the chunks of an uploaded line.
+#endif
 
 static void protocol_exec_rt_suspend();
+#ifdef ENABLE_AUTO_STATUS_REPORT
+  static void protocol_exec_rt_auto_report();
+#endif
+
+
+// Reports the execution status of a line. A successfully executed line also confirms any pending
+// serial baud rate change, since it could only have been received at the new baud rate.
+static void protocol_report_line_status(uint8_t status_code)
+{
+  #ifdef ENABLE_BAUD_RATE_SETTING
+    if (status_code == STATUS_OK) { serial_confirm_baud_rate(); }
+  #endif
+  report_status_message(status_code);
+}
+
+
+static const line_source_t serial_source = { serial_read };
+#ifdef ENABLE_FILE_STORAGE
+  static const line_source_t storage_source = { storage_read };
+#endif
+
+// Selects the source of the next line. A running file yields to the lines sent over the serial port
+// between its own lines, so the host can still pause the file or query Grbl.
+static const line_source_t *protocol_select_source()
+{
+  #ifdef ENABLE_FILE_STORAGE
+    if ((storage_get_state() == STORAGE_STATE_RUN) && !serial_get_rx_buffer_count()) {
+      return(&storage_source);
+    }
+  #endif
+  return(&serial_source);
+}
+
+
+#ifdef ENABLE_FILE_STORAGE
+// Executes a line read from a running stored file. Since there is no host to acknowledge, only
+// errors are reported, which also stop the file to prevent running the remainder out of context.
+static void protocol_execute_file_line(uint8_t line_flags)
+{
+  uint8_t status_code = STATUS_OK;
+  if (line_flags & LINE_FLAG_OVERFLOW) {
+    status_code = STATUS_OVERFLOW;
+  } else if (line[0] == '$') {
+    status_code = system_execute_line(line);
+  } else if (line[0] != 0) {
+    if (sys.state & (STATE_ALARM | STATE_JOG)) { status_code = STATUS_SYSTEM_GC_LOCK; }
+    else { status_code = gc_execute_line(line); }
+  }
+  if (status_code != STATUS_OK) {
+    report_status_message(status_code);
+    storage_stop();
+  }
+}
+
+
+// Returns true, if a line received during an upload is the '$FC' command closing the file. The
+// line is raw, so whitespace and letter case are ignored like on executed lines.
+static uint8_t protocol_is_close_line(char *raw)
+{
+  const char *close = "$FC";
+  for (; *raw; raw++) {
+    char c = *raw;
+    if (c <= ' ') { continue; }
+    if (c >= 'a' && c <= 'z') { c += 'A'-'a'; }
+    if (c != *close++) { return(false); }
+  }
+  return(*close == 0);
+}
+
+
+// Stores a line received during an upload in the file as is, instead of executing it. Lines longer
+// than the line buffer arrive in chunks and are acknowledged once, at their end.
+static void protocol_store_line(uint8_t line_status, uint8_t line_flags)
+{
+  uint8_t length = strlen(line);
+  if (line_status == LINE_CHUNK) {
+    if (upload_status == STATUS_OK) { upload_status = storage_write(line, length); }
+    return;
+  }
+  if (!(line_flags & LINE_FLAG_CONTINUED) && protocol_is_close_line(line)) {
+    upload_status = storage_close_file();
+  } else if (length || (line_flags & LINE_FLAG_CONTINUED)) { // Empty lines are not stored.
+    line[length++] = '\n'; // Replaces the string termination. Fits, since chunks leave it free.
+    if (upload_status == STATUS_OK) { upload_status = storage_write(line, length); }
+  }
+  report_status_message(upload_status);
+  upload_status = STATUS_OK;
+}
+#endif
+
+
+// Directs and executes one line of formatted input, and reports status of execution.
+static void protocol_execute_line(const line_source_t *source, uint8_t line_flags)
+{
+  #ifdef ENABLE_FILE_STORAGE
+    if (source == &storage_source) {
+      protocol_execute_file_line(line_flags);
+      return;
+    }
+  #endif
+  if (line_flags & LINE_FLAG_OVERFLOW) {
+    // Report line overflow error.
+    report_status_message(STATUS_OVERFLOW);
+  } else if (line[0] == 0) {
+    // Empty or comment line. For syncing purposes.
+    report_status_message(STATUS_OK);
+  } else if (line[0] == '$') {
+    // Grbl '$' system command
+    protocol_report_line_status(system_execute_line(line));
+  #ifdef ENABLE_FILE_STORAGE
+    } else if (storage_get_state() == STORAGE_STATE_RUN) {
+      // G-code from the host can't be merged into a running file.
+      report_status_message(STATUS_FILE_ERROR);
+  #endif
+  } else if (sys.state & (STATE_ALARM | STATE_JOG)) {
+    // Everything else is gcode. Block if in alarm or jog mode.
+    report_status_message(STATUS_SYSTEM_GC_LOCK);
+  } else {
+    // Parse and execute g-code block.
+    protocol_report_line_status(gc_execute_line(line));
+  }
+}
 
 
 /*
@@ -68,87 +187,53 @@ void protocol_main_loop()
   // This is also where Grbl idles while waiting for something to do.
   // ---------------------------------------------------------------------------------
 
-  uint8_t line_flags = 0;
-  uint8_t char_counter = 0;
-  uint8_t c;
+  line_reader_t reader = { LINE_MODE_GCODE, 0, 0 };
+  #ifdef ENABLE_FILE_STORAGE
+    upload_status = STATUS_OK;
+  #endif
+  const line_source_t *source = &serial_source;
+  uint8_t line_status;
   for (;;) {
 
-    // Process one line of incoming serial data, as the data becomes available. Performs an
-    // initial filtering by removing spaces and comments and capitalizing all letters.
-    while((c = serial_read()) != SERIAL_NO_DATA) {
-      if ((c == '\n') || (c == '\r')) { // End of line reached
-
-        protocol_execute_realtime(); // Runtime command check point.
-        if (sys.abort) { return; } // Bail to calling function upon system abort
-
-        line[char_counter] = 0; // Set string termination character.
-        #ifdef REPORT_ECHO_LINE_RECEIVED
-          report_echo_line_received(line);
-        #endif
-
-        // Direct and execute one line of formatted input, and report status of execution.
-        if (line_flags & LINE_FLAG_OVERFLOW) {
-          // Report line overflow error.
-          report_status_message(STATUS_OVERFLOW);
-        } else if (line[0] == 0) {
-          // Empty or comment line. For syncing purposes.
-          report_status_message(STATUS_OK);
-        } else if (line[0] == '$') {
-          // Grbl '$' system command
-          report_status_message(system_execute_line(line));
-        } else if (sys.state & (STATE_ALARM | STATE_JOG)) {
-          // Everything else is gcode. Block if in alarm or jog mode.
-          report_status_message(STATUS_SYSTEM_GC_LOCK);
-        } else {
-          // Parse and execute g-code block.
-          report_status_message(gc_execute_line(line));
-        }
-
-        // Reset tracking data for next line.
-        line_flags = 0;
-        char_counter = 0;
-
-      } else {
-
-        if (line_flags) {
-          // Throw away all (except EOL) comment characters and overflow characters.
-          if (c == ')') {
-            // End of '()' comment. Resume line allowed.
-            if (line_flags & LINE_FLAG_COMMENT_PARENTHESES) { line_flags &= ~(LINE_FLAG_COMMENT_PARENTHESES); }
-          }
-        } else {
-          if (c <= ' ') {
-            // Throw away whitepace and control characters
-          } else if (c == '/') {
-            // Block delete NOT SUPPORTED. Ignore character.
-            // NOTE: If supported, would simply need to check the system if block delete is enabled.
-          } else if (c == '(') {
-            // Enable comments flag and ignore all characters until ')' or EOL.
-            // NOTE: This doesn't follow the NIST definition exactly, but is good enough for now.
-            // In the future, we could simply remove the items within the comments, but retain the
-            // comment control characters, so that the g-code parser can error-check it.
-            line_flags |= LINE_FLAG_COMMENT_PARENTHESES;
-          } else if (c == ';') {
-            // NOTE: ';' comment to EOL is a LinuxCNC definition. Not NIST.
-            line_flags |= LINE_FLAG_COMMENT_SEMICOLON;
-          // TODO: Install '%' feature
-          // } else if (c == '%') {
-            // Program start-end percent sign NOT SUPPORTED.
-            // NOTE: This maybe installed to tell Grbl when a program is running vs manual input,
-            // where, during a program, the system auto-cycle start will continue to execute
-            // everything until the next '%' sign. This will help fix resuming issues with certain
-            // functions that empty the planner buffer to execute its task on-time.
-          } else if (char_counter >= (LINE_BUFFER_SIZE-1)) {
-            // Detect line buffer overflow and set flag.
-            line_flags |= LINE_FLAG_OVERFLOW;
-          } else if (c >= 'a' && c <= 'z') { // Upcase lowercase
-            line[char_counter++] = c-'a'+'A';
-          } else {
-            line[char_counter++] = c;
-          }
+    // Process one line of incoming data, as the data becomes available. The line reader performs
+    // an initial filtering by removing spaces and comments and capitalizing all letters. A new line
+    // may come from another source, but a partial line always continues from its own source.
+    if (!(reader.flags || reader.char_counter)) { source = protocol_select_source(); }
+    while((line_status = line_read(source, &reader, line)) != LINE_INCOMPLETE) {
+      #ifdef ENABLE_FILE_STORAGE
+        if (line_status == LINE_CHUNK) { // Part of a long uploaded line.
+          protocol_store_line(line_status, reader.flags);
+          continue;
         }
-
-      }
+      #endif
+
+      protocol_execute_realtime(); // Runtime command check point.
+      if (sys.abort) { return; } // Bail to calling function upon system abort
+
+      #ifdef REPORT_ECHO_LINE_RECEIVED
+        report_echo_line_received(line);
+      #endif
+
+      #ifdef ENABLE_FILE_STORAGE
+        if (reader.mode == LINE_MODE_RAW) {
+          // Store the line in the uploaded file, instead of executing it.
+          protocol_store_line(line_status, reader.flags);
+        } else
+      #endif
+      protocol_execute_line(source, reader.flags);
+
+      #ifdef ENABLE_PERF_COUNTERS
+        sys_perf.lines++;
+      #endif
+
+      // Reset tracking data for next line. Lines of an upload are kept as received.
+      reader.flags = 0;
+      reader.char_counter = 0;
+      #ifdef ENABLE_FILE_STORAGE
+        if (storage_get_state() == STORAGE_STATE_UPLOAD) { reader.mode = LINE_MODE_RAW; }
+        else { reader.mode = LINE_MODE_GCODE; }
+      #endif
+      source = protocol_select_source();
     }
 
     // If there are no more characters in the serial read buffer to be processed and executed,
@@ -156,6 +241,10 @@ void protocol_main_loop()
     // completed. In either case, auto-cycle start, if enabled, any queued moves.
     protocol_auto_cycle_start();
 
+    #ifdef ENABLE_BAUD_RATE_SETTING
+      serial_update_baud_rate(); // Apply, or revert unconfirmed, serial baud rate changes.
+    #endif
+
     protocol_execute_realtime();  // Runtime command check point.
     if (sys.abort) { return; } // Bail to main() program loop to reset system.
   }
@@ -177,6 +266,21 @@ void protocol_buffer_synchronize()
 }
 
 
+#ifdef SPINDLE_SPINUP_OVERLAP
+// Block until only rapids are left in the planner and step segment buffers, while they keep
+// executing. Used to change the spindle state at the start of the rapids leading up to the next
+// feed motion, once the stepper has completed every segment of the last feed motion.
+void protocol_rapid_synchronize()
+{
+  protocol_auto_cycle_start();
+  while (!plan_check_rapid_buffer() || !st_check_rapid_segments()) {
+    protocol_execute_realtime();   // Check and execute run-time commands
+    if (sys.abort) { return; } // Check for system abort
+  }
+}
+#endif
+
+
 // Auto-cycle start triggers when there is a motion ready to execute and if the main program is not
 // actively parsing commands.
 // NOTE: This function is called from the main loop, buffer sync, and mc_line() only and executes
@@ -248,7 +352,7 @@ void protocol_exec_rt_system()
 
     // Execute and serial print status
     if (rt_exec & EXEC_STATUS_REPORT) {
-      report_realtime_status();
+      report_realtime_status(false);
       system_clear_exec_state_flag(EXEC_STATUS_REPORT);
     }
 
@@ -402,6 +506,14 @@ void protocol_exec_rt_system()
     }
   }
 
+  #ifdef ENABLE_BINARY_STATUS_REPORT
+    // Execute and serial write binary status report
+    if (sys_rt_exec_report & EXEC_BINARY_STATUS_REPORT) {
+      report_binary_status();
+      system_clear_exec_report_flag(EXEC_BINARY_STATUS_REPORT);
+    }
+  #endif
+
   // Execute overrides.
   rt_exec = sys_rt_exec_motion_override; // Copy volatile sys_rt_exec_motion_override
   if (rt_exec) {
@@ -425,8 +537,10 @@ void protocol_exec_rt_system()
       sys.f_override = new_f_override;
       sys.r_override = new_r_override;
       sys.report_ovr_counter = 0; // Set to report change immediately
-      plan_update_velocity_profile_parameters();
-      plan_cycle_reinitialize();
+      // Replan only if the override changed any junction limits. Otherwise, only recompute the
+      // velocity profile of the executing block with its new nominal speed.
+      if (plan_update_velocity_profile_parameters()) { plan_cycle_reinitialize(); }
+      else { st_update_plan_block_parameters(); }
     }
   }
 
@@ -498,7 +612,38 @@ void protocol_exec_rt_system()
     st_prep_buffer();
   }
 
+  #ifdef ENABLE_VELOCITY_JOG
+    jog_velocity_watchdog(); // Stop velocity jogs no longer refreshed by the host.
+  #endif
+
+  #ifdef ENABLE_AUTO_STATUS_REPORT
+    // Push periodic status reports while in motion, if enabled by the '$41' interval setting.
+    if (settings.status_report_interval) { protocol_exec_rt_auto_report(); }
+  #endif
+
+}
+
+
+#ifdef ENABLE_AUTO_STATUS_REPORT
+// Sends automatic status reports every status report interval while running, jogging, or in a
+// feed hold, so hosts don't need to poll with '?'. One last report is sent upon leaving these
+// states to show the final position.
+static void protocol_exec_rt_auto_report()
+{
+  static uint32_t report_time;
+  static uint8_t report_active = false;
+  uint32_t current_time = system_get_millis();
+  if (sys.state & (STATE_CYCLE | STATE_HOLD | STATE_JOG)) {
+    if (report_active && ((current_time-report_time) < settings.status_report_interval)) { return; }
+    report_active = true;
+  } else {
+    if (!report_active) { return; }
+    report_active = false;
+  }
+  report_time = current_time;
+  report_realtime_status(report_active);
 }
+#endif
 
 
 // Handles Grbl system suspend procedures, such as feed hold, safety door, and parking motion.
@@ -46,4 +46,9 @@ void protocol_auto_cycle_start();
 // Block until all buffered steps are executed
 void protocol_buffer_synchronize();
 
+#ifdef SPINDLE_SPINUP_OVERLAP
+  // Block until all buffered feed motion steps are executed. Buffered rapids keep executing.
+  void protocol_rapid_synchronize();
+#endif
+
 #endif
@@ -0,0 +1,229 @@
+/*
+  raster.c - Compact raster engraving mode for laser images
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.h"
+
+#ifdef ENABLE_LASER_RASTER
+
+// Repeat prefix of a pixel run in the '$L=' payload.
+#define RASTER_REPEAT_CHAR '*'
+
+// Pixel run ring buffer. Filled by the '$L=' lines and emptied by the step segment generator in
+// the same order as their planner blocks. Both run in the main program.
+static raster_run_t raster_buffer[RASTER_BUFFER_SIZE];
+static uint8_t raster_buffer_tail;
+static uint8_t raster_buffer_head;
+
+// Scanline setup from the last '$LS=' line.
+static struct {
+  float pitch;         // Signed X pixel pitch (mm). Zero, if not set up.
+  float feed_rate;     // Scanline feed rate (mm/min)
+  float spindle_speed; // Full scale pixel power
+} raster;
+
+
+static uint8_t raster_next_run_index(uint8_t run_index)
+{
+  run_index++;
+  if (run_index == RASTER_BUFFER_SIZE) { run_index = 0; }
+  return(run_index);
+}
+
+
+void raster_reset()
+{
+  raster_buffer_tail = 0;
+  raster_buffer_head = 0; // Empty = tail
+}
+
+
+raster_run_t *raster_get_current_run()
+{
+  if (raster_buffer_head == raster_buffer_tail) { return(NULL); }
+  return(&raster_buffer[raster_buffer_tail]);
+}
+
+
+void raster_discard_current_run()
+{
+  if (raster_buffer_head != raster_buffer_tail) {
+    raster_buffer_tail = raster_next_run_index(raster_buffer_tail);
+  }
+}
+
+
+// Returns the value (0-31) of a base32 character '0'-'9','A'-'V', or 0xFF if it isn't one.
+// NOTE: The payload passes the g-code line filter, which upcases letters and drops whitespace, '/',
+// and comments. The alphabet has none of these, so the pixels arrive unchanged.
+static uint8_t raster_decode_char(char c)
+{
+  if ((c >= '0') && (c <= '9')) { return(c-'0'); }
+  if ((c >= 'A') && (c <= 'V')) { return(c-'A'+10); }
+  return(0xFF);
+}
+
+
+// Plans the pixels following the current parser position as a single line along the scanline.
+// Their power runs must already be queued in the raster buffer.
+static void raster_buffer_pixels(uint16_t pixels)
+{
+  float target[N_AXIS];
+  memcpy(target, gc_state.position, sizeof(target));
+  target[X_AXIS] += pixels*raster.pitch;
+
+  plan_line_data_t plan_data;
+  memset(&plan_data, 0, sizeof(plan_line_data_t));
+  plan_data.feed_rate = raster.feed_rate;
+  plan_data.spindle_speed = raster.spindle_speed;
+  plan_data.condition = (gc_state.modal.spindle | gc_state.modal.coolant);
+  plan_data.raster_pixels = pixels;
+  mc_line(target, &plan_data);
+  memcpy(gc_state.position, target, sizeof(target));
+}
+
+
+// Sets up the scanline from a '$LS=X..Y..P..F..S..' line and rapids to its start, if given.
+static uint8_t raster_setup(char *line)
+{
+  float start[N_AXIS];
+  uint8_t start_words = 0;
+  float pitch = 0.0;
+  float feed_rate = gc_state.feed_rate;
+  float spindle_speed = gc_state.spindle_speed;
+  float value;
+  uint8_t char_counter = 4; // Skip '$LS='
+  char letter;
+  uint8_t idx;
+  while (line[char_counter] != 0) {
+    letter = line[char_counter++];
+    if (!read_float(line, &char_counter, &value)) { return(STATUS_BAD_NUMBER_FORMAT); }
+    if (gc_state.modal.units == UNITS_MODE_INCHES) {
+      if (letter != 'S') { value *= MM_PER_INCH; }
+    }
+    switch (letter) {
+      case 'X': start[X_AXIS] = value; bit_true(start_words,bit(X_AXIS)); break;
+      case 'Y': start[Y_AXIS] = value; bit_true(start_words,bit(Y_AXIS)); break;
+      case 'P': pitch = value; break;
+      case 'F': feed_rate = value; break;
+      case 'S': spindle_speed = value; break;
+      default: return(STATUS_INVALID_STATEMENT);
+    }
+  }
+  // A pixel must move at least one step, or its planner block would be empty.
+  if (fabs(pitch)*settings.steps_per_mm[X_AXIS] < 1.0) { return(STATUS_INVALID_STATEMENT); }
+  if (feed_rate <= 0.0) { return(STATUS_GCODE_UNDEFINED_FEED_RATE); }
+  if (spindle_speed < 0.0) { return(STATUS_NEGATIVE_VALUE); }
+  raster.pitch = pitch;
+  raster.feed_rate = feed_rate;
+  raster.spindle_speed = spindle_speed;
+
+  if (start_words) {
+    // Rapid to the scanline start given in work coordinates. Laser mode disables the laser.
+    float target[N_AXIS];
+    memcpy(target, gc_state.position, sizeof(target));
+    for (idx=0; idx<N_AXIS; idx++) {
+      if (bit_istrue(start_words,bit(idx))) {
+        target[idx] = start[idx] + gc_state.coord_system[idx] + gc_state.coord_offset[idx];
+      }
+    }
+    plan_line_data_t plan_data;
+    memset(&plan_data, 0, sizeof(plan_line_data_t));
+    plan_data.condition = (gc_state.modal.spindle | gc_state.modal.coolant | PL_COND_FLAG_RAPID_MOTION);
+    if (bit_isfalse(settings.flags,BITFLAG_LASER_MODE)) { plan_data.spindle_speed = gc_state.spindle_speed; }
+    mc_line(target, &plan_data);
+    memcpy(gc_state.position, target, sizeof(target));
+  }
+  return(STATUS_OK);
+}
+
+
+// Queues the pixels of a '$L=' line as power runs in the raster buffer and plans them as a
+// single line. If the raster buffer fills, the queued runs are planned and the rest of the line
+// waits for the step segment generator to consume them.
+static uint8_t raster_pixels(char *line)
+{
+  if (raster.pitch == 0.0) { return(STATUS_INVALID_STATEMENT); } // No '$LS=' setup yet.
+
+  // Check the whole payload first, so an invalid line doesn't move at all.
+  uint8_t char_counter = 3; // Skip '$L='
+  while (line[char_counter] != 0) {
+    if (line[char_counter] == RASTER_REPEAT_CHAR) {
+      if (raster_decode_char(line[++char_counter]) == 0xFF) { return(STATUS_BAD_NUMBER_FORMAT); }
+      char_counter++;
+    }
+    if (raster_decode_char(line[char_counter++]) == 0xFF) { return(STATUS_BAD_NUMBER_FORMAT); }
+  }
+
+  uint16_t pixels = 0; // Pixels of the queued runs not yet planned.
+  uint8_t count, power;
+  raster_run_t *run;
+  char_counter = 3;
+  while (line[char_counter] != 0) {
+    count = 1;
+    if (line[char_counter] == RASTER_REPEAT_CHAR) {
+      count = raster_decode_char(line[++char_counter])+2;
+      char_counter++;
+    }
+    power = raster_decode_char(line[char_counter++]);
+
+    // In check mode, no motion is planned and nothing consumes the raster buffer.
+    if (sys.state == STATE_CHECK_MODE) { pixels += count; continue; }
+
+    // Merge with the previous run of this line, if it has the same power.
+    if (pixels) {
+      run = &raster_buffer[(raster_buffer_head == 0 ? RASTER_BUFFER_SIZE : raster_buffer_head)-1];
+      if ((run->power == power) && (run->pixels <= (255-count))) {
+        run->pixels += count;
+        pixels += count;
+        continue;
+      }
+    }
+
+    // If the buffer is full: plan the queued runs and wait for room in the buffer.
+    if (raster_next_run_index(raster_buffer_head) == raster_buffer_tail) {
+      if (pixels) {
+        raster_buffer_pixels(pixels);
+        pixels = 0;
+      }
+      do {
+        protocol_execute_realtime(); // Check for any run-time commands
+        if (sys.abort) { return(STATUS_OK); } // Bail, if system abort.
+        protocol_auto_cycle_start();
+      } while (raster_next_run_index(raster_buffer_head) == raster_buffer_tail);
+    }
+    run = &raster_buffer[raster_buffer_head];
+    run->pixels = count;
+    run->power = power;
+    raster_buffer_head = raster_next_run_index(raster_buffer_head);
+    pixels += count;
+  }
+  if (pixels) { raster_buffer_pixels(pixels); }
+  return(STATUS_OK);
+}
+
+
+uint8_t raster_execute_line(char *line)
+{
+  // Raster lines are motions, so they are locked out like g-code lines.
+  if (sys.state & (STATE_ALARM | STATE_JOG)) { return(STATUS_SYSTEM_GC_LOCK); }
+  if ((line[2] == 'S') && (line[3] == '=')) { return(raster_setup(line)); }
+  if (line[2] != '=') { return(STATUS_INVALID_STATEMENT); }
+  return(raster_pixels(line));
+}
+
+#endif
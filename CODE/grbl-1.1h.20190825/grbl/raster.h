@@ -0,0 +1,47 @@
+/*
+  raster.h - Compact raster engraving mode for laser images
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef raster_h
+#define raster_h
+
+#ifdef ENABLE_LASER_RASTER
+
+// Maximum pixel power value of the one character base32 pixel encoding.
+#define RASTER_POWER_MAX 31
+
+// A run of pixels with equal power, queued in the raster buffer along with its planner block.
+typedef struct {
+  uint8_t pixels; // Number of pixels in the run.
+  uint8_t power;  // Pixel power (0-RASTER_POWER_MAX) as a fraction of the block spindle speed.
+} raster_run_t;
+
+// Clears the raster buffer. Called whenever the planner buffer is reset.
+void raster_reset();
+
+// Executes a '$LS=' scanline setup or a '$L=' scanline pixel line.
+uint8_t raster_execute_line(char *line);
+
+// Gets the first queued pixel run. Returns NULL if buffer empty.
+raster_run_t *raster_get_current_run();
+
+// Called by the step segment buffer when the run has been prepped. Makes its memory available.
+void raster_discard_current_run();
+
+#endif
+
+#endif
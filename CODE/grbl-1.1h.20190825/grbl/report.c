@@ -44,6 +44,21 @@ static void report_util_axis_values(float *axis_value) {
   }
 }
 
+#ifdef REPORT_POSITION_FIXED_POINT
+  // Fixed-point conversion of each axis from machine steps to reported coordinates. Avoids the float
+  // division and decimal scaling for every axis of every status report. See report_update_position_scale().
+  static coord_steps_t report_position_coord[N_AXIS];
+
+  // Prints a step position vector, less an optional mm offset vector, as reported coordinates.
+  static void report_util_axis_steps(int32_t *steps, float *offset) {
+    uint8_t idx;
+    for (idx=0; idx<N_AXIS; idx++) {
+      printCoord_Steps(&report_position_coord[idx],steps[idx],(offset ? offset[idx] : 0.0));
+      if (idx < (N_AXIS-1)) { serial_write(','); }
+    }
+  }
+#endif
+
 /*
 static void report_util_setting_string(uint8_t n) {
   serial_write(' ');
@@ -96,11 +111,50 @@ static void report_util_uint8_setting(uint8_t n, int val) {
   print_uint8_base10(val); 
   report_util_line_feed(); // report_util_setting_string(n); 
 }
+static void report_util_uint32_setting(uint8_t n, uint32_t val) {
+  report_util_setting_prefix(n);
+  print_uint32_base10(val);
+  report_util_line_feed();
+}
 static void report_util_float_setting(uint8_t n, float val, uint8_t n_decimal) { 
   report_util_setting_prefix(n); 
   printFloat(val,n_decimal);
   report_util_line_feed(); // report_util_setting_string(n);
 }
+#ifdef ENABLE_PERF_COUNTERS
+  // Prints the performance counter values. Lines per second are sampled over at least a second
+  // by whichever report comes next, '$P' or status report.
+  static void report_util_perf_counters() {
+    static uint32_t sample_lines;
+    static uint32_t sample_millis;
+    static uint32_t lines_rate;
+    perf_t perf;
+    uint8_t sreg = SREG;
+    cli(); // Counters are updated by the serial and stepper ISRs.
+    memcpy(&perf,(void*)&sys_perf,sizeof(perf_t));
+    SREG = sreg;
+    uint32_t millis = system_get_millis();
+    if (perf.lines < sample_lines) { sample_lines = 0; } // Counters cleared by a reset.
+    if ((millis-sample_millis) >= 1000) {
+      lines_rate = ((perf.lines-sample_lines)*1000)/(millis-sample_millis);
+      sample_lines = perf.lines;
+      sample_millis = millis;
+    }
+    uint8_t speed_percent = 0;
+    if (perf.programmed_sum > 0.0) { speed_percent = min(255.0, 100.0*perf.peak_speed_sum/perf.programmed_sum); }
+    print_uint32_base10(perf.rx_full);
+    serial_write(',');
+    print_uint32_base10(lines_rate);
+    serial_write(',');
+    print_uint32_base10(perf.planner_empty);
+    serial_write(',');
+    print_uint32_base10(perf.underruns);
+    serial_write(',');
+    print_uint8_base10(speed_percent);
+    serial_write(',');
+    print_uint32_base10(perf.rejected);
+  }
+#endif
 
 
 // Handles the primary confirmation protocol response for streaming interfaces and human-feedback.
@@ -161,6 +215,16 @@ void report_feedback_message(uint8_t message_code)
       printPgmString(PSTR("Restoring spindle")); break;
     case MESSAGE_SLEEP_MODE:
       printPgmString(PSTR("Sleeping")); break;
+    #ifdef ENABLE_BAUD_RATE_SETTING
+      case MESSAGE_BAUD_RATE_RESTORED:
+        printPgmString(PSTR("Baud rate restored")); break;
+    #endif
+    case MESSAGE_FILE_DONE:
+      printPgmString(PSTR("File done")); break;
+    case MESSAGE_FILE_STOPPED:
+      printPgmString(PSTR("File stopped")); break;
+    case MESSAGE_FILE_PAUSED:
+      printPgmString(PSTR("File paused")); break;
   }
   report_util_feedback_line_feed();
 }
@@ -208,6 +272,12 @@ void report_grbl_settings() {
   #else
     report_util_uint8_setting(32,0);
   #endif
+  #ifdef ENABLE_BAUD_RATE_SETTING
+    report_util_uint32_setting(40,settings.baud_rate);
+  #endif
+  #ifdef ENABLE_AUTO_STATUS_REPORT
+    report_util_uint32_setting(41,settings.status_report_interval);
+  #endif
   // Print axis settings
   uint8_t idx, set_idx;
   uint8_t val = AXIS_SETTINGS_START_VAL;
@@ -366,6 +436,25 @@ void report_execute_startup_message(char *line, uint8_t status_code)
   report_status_message(status_code);
 }
 
+#ifdef ENABLE_PERF_COUNTERS
+  // Prints the runtime performance counters. See config.h for their order.
+  void report_perf_counters()
+  {
+    printPgmString(PSTR("[PC:"));
+    report_util_perf_counters();
+    report_util_feedback_line_feed();
+  }
+#endif
+
+void report_file_entry(char *name, uint32_t length)
+{
+  printPgmString(PSTR("[FILE:"));
+  printString(name);
+  serial_write(',');
+  print_uint32_base10(length);
+  report_util_feedback_line_feed();
+}
+
 // Prints build info line
 void report_build_info(char *line)
 {
@@ -439,11 +528,26 @@ void report_build_info(char *line)
   #ifdef ENABLE_DUAL_AXIS
     serial_write('2');
   #endif
+  #ifdef ENABLE_SERIAL_FLOW_CONTROL
+    serial_write('F');
+  #endif
+  #ifdef ENABLE_FILE_STORAGE
+    serial_write('U');
+  #endif
+  #ifdef ENABLE_VELOCITY_JOG
+    serial_write('J');
+  #endif
+  #ifdef ENABLE_LASER_RASTER
+    serial_write('B');
+  #endif
+  #ifdef ENABLE_PERF_COUNTERS
+    serial_write('Q');
+  #endif
   // NOTE: Compiled values, like override increments/max/min values, may be added at some point later.
   serial_write(',');
   print_uint8_base10(BLOCK_BUFFER_SIZE-1);
   serial_write(',');
-  print_uint8_base10(RX_BUFFER_SIZE);
+  print_uint32_base10(RX_BUFFER_SIZE);
 
   report_util_feedback_line_feed();
 }
@@ -458,18 +562,52 @@ void report_echo_line_received(char *line)
 }
 
 
+// Updates the status report position scale factors. Called whenever the steps/mm or report
+// inches settings may have changed.
+#ifdef REPORT_POSITION_FIXED_POINT
+void report_update_position_scale()
+{
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    printCoord_SetScale(&report_position_coord[idx],settings.steps_per_mm[idx]);
+  }
+}
+#endif
+
+
  // Prints real-time data. This function grabs a real-time snapshot of the stepper subprogram
  // and the actual location of the CNC machine. Users may change the following function to their
  // specific needs, but the desired real-time data report must be as short as possible. This is
  // requires as it minimizes the computational overhead and allows grbl to keep running smoothly,
  // especially during g-code programs with fast, short line segments and high frequency reports (5-20Hz).
-void report_realtime_status()
+void report_realtime_status(uint8_t auto_report)
 {
   uint8_t idx;
   int32_t current_position[N_AXIS]; // Copy current state of the system position variable
   memcpy(current_position,sys_position,sizeof(sys_position));
-  float print_position[N_AXIS];
-  system_convert_array_steps_to_mpos(print_position,current_position);
+
+  #ifdef REPORT_AUTO_SUPPRESS_UNCHANGED
+    // Skip automatic reports, if the machine hasn't moved or changed state since the last report.
+    static int32_t report_position[N_AXIS];
+    static uint8_t report_state, report_suspend;
+    if (auto_report && (sys.state == report_state) && (sys.suspend == report_suspend) &&
+        !memcmp(current_position,report_position,sizeof(current_position))) { return; }
+    memcpy(report_position,current_position,sizeof(current_position));
+    report_state = sys.state;
+    report_suspend = sys.suspend;
+  #endif
+
+  #ifdef REPORT_POSITION_FIXED_POINT
+    #ifdef COREXY
+      // Convert motor steps to cartesian axis steps. Integer operations only.
+      int32_t x_axis_steps = system_convert_corexy_to_x_axis_steps(current_position);
+      current_position[Y_AXIS] = system_convert_corexy_to_y_axis_steps(current_position);
+      current_position[X_AXIS] = x_axis_steps;
+    #endif
+  #else
+    float print_position[N_AXIS];
+    system_convert_array_steps_to_mpos(print_position,current_position);
+  #endif
 
   // Report current machine state and sub-states
   serial_write('<');
@@ -513,27 +651,56 @@ void report_realtime_status()
       // Apply work coordinate offsets and tool length offset to current position.
       wco[idx] = gc_state.coord_system[idx]+gc_state.coord_offset[idx];
       if (idx == TOOL_LENGTH_OFFSET_AXIS) { wco[idx] += gc_state.tool_length_offset; }
-      if (bit_isfalse(settings.status_report_mask,BITFLAG_RT_STATUS_POSITION_TYPE)) {
-        print_position[idx] -= wco[idx];
-      }
+      #ifndef REPORT_POSITION_FIXED_POINT
+        if (bit_isfalse(settings.status_report_mask,BITFLAG_RT_STATUS_POSITION_TYPE)) {
+          print_position[idx] -= wco[idx];
+        }
+      #endif
     }
   }
 
-  // Report machine position
+  // Report machine position. Work position applies the work coordinate offsets.
   if (bit_istrue(settings.status_report_mask,BITFLAG_RT_STATUS_POSITION_TYPE)) {
     printPgmString(PSTR("|MPos:"));
+    #ifdef REPORT_POSITION_FIXED_POINT
+      report_util_axis_steps(current_position,NULL);
+    #endif
   } else {
     printPgmString(PSTR("|WPos:"));
+    #ifdef REPORT_POSITION_FIXED_POINT
+      report_util_axis_steps(current_position,wco);
+    #endif
   }
-  report_util_axis_values(print_position);
+  #ifndef REPORT_POSITION_FIXED_POINT
+    report_util_axis_values(print_position);
+  #endif
 
   // Returns planner and serial read buffer states.
   #ifdef REPORT_FIELD_BUFFER_STATE
     if (bit_istrue(settings.status_report_mask,BITFLAG_RT_STATUS_BUFFER_STATE)) {
-      printPgmString(PSTR("|Bf:"));
-      print_uint8_base10(plan_get_block_buffer_available());
-      serial_write(',');
-      print_uint8_base10(serial_get_rx_buffer_available());
+      uint8_t plan_available = plan_get_block_buffer_available();
+      serial_rx_index_t rx_available = serial_get_rx_buffer_available();
+      uint8_t report_field = true;
+      #ifdef REPORT_AUTO_CHANGED_FIELDS_ONLY
+        // Omitted from automatic reports, unless changed since the last report.
+        static uint8_t report_plan_available;
+        static serial_rx_index_t report_rx_available;
+        if (auto_report && (plan_available == report_plan_available) && (rx_available == report_rx_available)) {
+          report_field = false;
+        }
+        report_plan_available = plan_available;
+        report_rx_available = rx_available;
+      #endif
+      if (report_field) {
+        printPgmString(PSTR("|Bf:"));
+        print_uint8_base10(plan_available);
+        serial_write(',');
+        #if (RX_BUFFER_SIZE > 254)
+          print_uint32_base10(rx_available);
+        #else
+          print_uint8_base10(rx_available);
+        #endif
+      }
     }
   #endif
 
@@ -553,15 +720,33 @@ void report_realtime_status()
 
   // Report realtime feed speed
   #ifdef REPORT_FIELD_CURRENT_FEED_SPEED
-    #ifdef VARIABLE_SPINDLE
-      printPgmString(PSTR("|FS:"));
-      printFloat_RateValue(st_get_realtime_rate());
-      serial_write(',');
-      printFloat(sys.spindle_speed,N_DECIMAL_RPMVALUE);
-    #else
-      printPgmString(PSTR("|F:"));
-      printFloat_RateValue(st_get_realtime_rate());
-    #endif      
+    float feed_rate = st_get_realtime_rate();
+    uint8_t report_field = true;
+    #ifdef REPORT_AUTO_CHANGED_FIELDS_ONLY
+      // Omitted from automatic reports, unless changed since the last report.
+      static float report_feed_rate;
+      #ifdef VARIABLE_SPINDLE
+        static float report_spindle_speed;
+        if (auto_report && (feed_rate == report_feed_rate) && (sys.spindle_speed == report_spindle_speed)) {
+          report_field = false;
+        }
+        report_spindle_speed = sys.spindle_speed;
+      #else
+        if (auto_report && (feed_rate == report_feed_rate)) { report_field = false; }
+      #endif
+      report_feed_rate = feed_rate;
+    #endif
+    if (report_field) {
+      #ifdef VARIABLE_SPINDLE
+        printPgmString(PSTR("|FS:"));
+        printFloat_RateValue(feed_rate);
+        serial_write(',');
+        printFloat(sys.spindle_speed,N_DECIMAL_RPMVALUE);
+      #else
+        printPgmString(PSTR("|F:"));
+        printFloat_RateValue(feed_rate);
+      #endif
+    }
   #endif
 
   #ifdef REPORT_FIELD_PIN_STATE
@@ -649,11 +834,46 @@ void report_realtime_status()
     }
   #endif
 
+  #ifdef REPORT_FIELD_PERF_COUNTERS
+    printPgmString(PSTR("|Pc:"));
+    report_util_perf_counters();
+  #endif
+
   serial_write('>');
   report_util_line_feed();
 }
 
 
+#ifdef ENABLE_BINARY_STATUS_REPORT
+// Writes a binary status report. A compact alternative to the realtime status report for hosts
+// polling at high rates, which skips all float conversion and formatting. Frame defined in report.h.
+void report_binary_status()
+{
+  uint8_t frame[REPORT_BINARY_STATUS_LENGTH];
+  uint8_t idx = 0;
+  frame[idx++] = REPORT_BINARY_STATUS_MARKER;
+  frame[idx++] = REPORT_BINARY_STATUS_LENGTH;
+  frame[idx++] = sys.state;
+  frame[idx++] = sys.suspend;
+  memcpy(&frame[idx],sys_position,sizeof(sys_position)); // AVR is little-endian.
+  idx += sizeof(sys_position);
+  frame[idx++] = plan_get_block_buffer_available();
+  uint16_t rx_available = serial_get_rx_buffer_available();
+  frame[idx++] = rx_available & 0xFF;
+  frame[idx++] = rx_available >> 8;
+  frame[idx++] = sys.f_override;
+  frame[idx++] = sys.r_override;
+  frame[idx++] = sys.spindle_speed_ovr;
+
+  uint8_t checksum = 0;
+  for (idx=1; idx<(REPORT_BINARY_STATUS_LENGTH-1); idx++) { checksum ^= frame[idx]; }
+  frame[idx] = checksum;
+
+  for (idx=0; idx<REPORT_BINARY_STATUS_LENGTH; idx++) { serial_write(frame[idx]); }
+}
+#endif
+
+
 #ifdef DEBUG
   void report_realtime_debug()
   {
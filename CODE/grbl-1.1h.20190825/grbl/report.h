@@ -39,6 +39,8 @@
 #define STATUS_TRAVEL_EXCEEDED 15
 #define STATUS_INVALID_JOG_COMMAND 16
 #define STATUS_SETTING_DISABLED_LASER 17
+#define STATUS_SETTING_INVALID_BAUD_RATE 18
+#define STATUS_FILE_ERROR 19
 
 #define STATUS_GCODE_UNSUPPORTED_COMMAND 20
 #define STATUS_GCODE_MODAL_GROUP_VIOLATION 21
@@ -83,6 +85,10 @@
 #define MESSAGE_RESTORE_DEFAULTS 9
 #define MESSAGE_SPINDLE_RESTORE 10
 #define MESSAGE_SLEEP_MODE 11
+#define MESSAGE_BAUD_RATE_RESTORED 12
+#define MESSAGE_FILE_DONE 13
+#define MESSAGE_FILE_STOPPED 14
+#define MESSAGE_FILE_PAUSED 15
 
 // Prints system status messages.
 void report_status_message(uint8_t status_code);
@@ -105,8 +111,29 @@ void report_grbl_settings();
 // Prints an echo of the pre-parsed line received right before execution.
 void report_echo_line_received(char *line);
 
-// Prints realtime status report
-void report_realtime_status();
+#ifdef ENABLE_BINARY_STATUS_REPORT
+  // Define binary status report frame. All multi-byte values are little-endian. Positions are in
+  // machine steps, which the host converts with the steps/mm settings. The checksum is the XOR of all
+  // bytes from the length to the last data byte.
+  //   [0] Marker  [1] Frame length  [2] State  [3] Suspend flags  [4..] Position (int32 x N_AXIS)
+  //   Planner blocks available (uint8)  RX bytes available (uint16)
+  //   Feed, rapid, and spindle overrides (uint8 x 3)  Checksum (uint8)
+  #define REPORT_BINARY_STATUS_MARKER 0xA5 // Never sent in ASCII messages.
+  #define REPORT_BINARY_STATUS_LENGTH (4+4*N_AXIS+3+3+1)
+#endif
+
+#ifdef REPORT_POSITION_FIXED_POINT
+  // Updates the cached scale factors for reporting positions. Call upon steps/mm or units changes.
+  void report_update_position_scale();
+#endif
+
+// Prints realtime status report. Automatic reports may omit unchanged data, if configured.
+void report_realtime_status(uint8_t auto_report);
+
+#ifdef ENABLE_BINARY_STATUS_REPORT
+  // Writes compact binary status report
+  void report_binary_status();
+#endif
 
 // Prints recorded probe position
 void report_probe_parameters();
@@ -121,6 +148,14 @@ void report_gcode_modes();
 void report_startup_line(uint8_t n, char *line);
 void report_execute_startup_message(char *line, uint8_t status_code);
 
+#ifdef ENABLE_PERF_COUNTERS
+  // Prints the runtime performance counters.
+  void report_perf_counters();
+#endif
+
+// Prints a stored file name and size when listed.
+void report_file_entry(char *name, uint32_t length);
+
 // Prints build info and user info
 void report_build_info(char *line);
 
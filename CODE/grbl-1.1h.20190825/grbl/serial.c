@@ -25,30 +25,56 @@
 #define TX_RING_BUFFER (TX_BUFFER_SIZE+1)
 
 uint8_t serial_rx_buffer[RX_RING_BUFFER];
-uint8_t serial_rx_buffer_head = 0;
-volatile uint8_t serial_rx_buffer_tail = 0;
+serial_rx_index_t serial_rx_buffer_head = 0;
+volatile serial_rx_index_t serial_rx_buffer_tail = 0;
 
 uint8_t serial_tx_buffer[TX_RING_BUFFER];
 uint8_t serial_tx_buffer_head = 0;
 volatile uint8_t serial_tx_buffer_tail = 0;
 
 
+// Atomic access to the RX ring indices shared with the RX ISR. Only required with 16-bit indices,
+// where the ISR may otherwise fire between the low and high byte access by the main program.
+#if (RX_BUFFER_SIZE > 254)
+  static serial_rx_index_t serial_rx_get_head()
+  {
+    uint8_t sreg = SREG;
+    cli();
+    serial_rx_index_t head = serial_rx_buffer_head;
+    SREG = sreg;
+    return(head);
+  }
+  static void serial_rx_set_tail(serial_rx_index_t tail)
+  {
+    uint8_t sreg = SREG;
+    cli();
+    serial_rx_buffer_tail = tail;
+    SREG = sreg;
+  }
+#else
+  #define serial_rx_get_head() serial_rx_buffer_head
+  #define serial_rx_set_tail(tail) serial_rx_buffer_tail = tail
+#endif
+
+
 // Returns the number of bytes available in the RX serial buffer.
-uint8_t serial_get_rx_buffer_available()
+serial_rx_index_t serial_get_rx_buffer_available()
 {
-  uint8_t rtail = serial_rx_buffer_tail; // Copy to limit multiple calls to volatile
-  if (serial_rx_buffer_head >= rtail) { return(RX_BUFFER_SIZE - (serial_rx_buffer_head-rtail)); }
-  return((rtail-serial_rx_buffer_head-1));
+  serial_rx_index_t rhead = serial_rx_get_head();
+  serial_rx_index_t rtail = serial_rx_buffer_tail; // Copy to limit multiple calls to volatile
+  if (rhead >= rtail) { return(RX_BUFFER_SIZE - (rhead-rtail)); }
+  return((rtail-rhead-1));
 }
 
 
 // Returns the number of bytes used in the RX serial buffer.
-// NOTE: Deprecated. Not used unless classic status reports are enabled in config.h.
-uint8_t serial_get_rx_buffer_count()
+// NOTE: Only used by the optional RTS flow control to check the low watermark.
+serial_rx_index_t serial_get_rx_buffer_count()
 {
-  uint8_t rtail = serial_rx_buffer_tail; // Copy to limit multiple calls to volatile
-  if (serial_rx_buffer_head >= rtail) { return(serial_rx_buffer_head-rtail); }
-  return (RX_BUFFER_SIZE - (rtail-serial_rx_buffer_head));
+  serial_rx_index_t rhead = serial_rx_get_head();
+  serial_rx_index_t rtail = serial_rx_buffer_tail; // Copy to limit multiple calls to volatile
+  if (rhead >= rtail) { return(rhead-rtail); }
+  return (RX_BUFFER_SIZE - (rtail-rhead));
 }
 
 
@@ -62,18 +88,128 @@ uint8_t serial_get_tx_buffer_count()
 }
 
 
-void serial_init()
+#ifdef ENABLE_BAUD_RATE_SETTING
+// Runtime baud rate management. A baud rate change requested by a '$' setting is only applied
+// after its response is sent and is reverted, unless a valid line is received at the new baud
+// rate within SERIAL_BAUD_ROLLBACK_TIMEOUT. Only then is the new baud rate stored in EEPROM.
+static uint32_t serial_baud_rate = BAUD_RATE; // Active baud rate.
+static uint32_t serial_baud_pending = 0;      // Requested baud rate. Zero if none.
+static uint32_t serial_baud_rollback = 0;     // Prior baud rate to revert to. Zero if confirmed.
+static uint32_t serial_baud_timeout;          // Rollback deadline in system milliseconds.
+
+
+// Returns if the baud rate is supported. Only rates with an exact or near-exact UBRR divisor
+// at 16MHz are allowed, along with the compile-time default.
+uint8_t serial_baud_rate_is_valid(uint32_t baud)
 {
-  // Set baud rate
-  #if BAUD_RATE < 57600
-    uint16_t UBRR0_value = ((F_CPU / (8L * BAUD_RATE)) - 1)/2 ;
+  if (baud == BAUD_RATE) { return(true); }
+  switch (baud) {
+    case 115200: case 230400: case 250000: case 500000: case 1000000:
+      return(true);
+  }
+  return(false);
+}
+
+
+// Sets the USART baud rate. The baud doubler is used for high baud rates, which halves the
+// divisor step size. The divisor is rounded to the nearest value to minimize the baud error.
+// NOTE: Any data being transmitted is corrupted. Must be drained before calling.
+void serial_set_baud_rate(uint32_t baud)
+{
+  uint16_t UBRR0_value;
+  if (baud < 57600) {
+    UBRR0_value = ((F_CPU / (8L * baud)) - 1)/2 ;
     UCSR0A &= ~(1 << U2X0); // baud doubler off  - Only needed on Uno XXX
-  #else
-    uint16_t UBRR0_value = ((F_CPU / (4L * BAUD_RATE)) - 1)/2;
+  } else {
+    UBRR0_value = ((F_CPU / (4L * baud)) - 1)/2;
     UCSR0A |= (1 << U2X0);  // baud doubler on for high baud rates, i.e. 115200
-  #endif
+  }
   UBRR0H = UBRR0_value >> 8;
   UBRR0L = UBRR0_value;
+  serial_baud_rate = baud;
+}
+
+
+// Requests a baud rate change. Applied by serial_update_baud_rate() once the response is sent.
+void serial_request_baud_rate(uint32_t baud)
+{
+  if (baud != serial_baud_rate) { serial_baud_pending = baud; }
+}
+
+
+// Applies a requested baud rate change and reverts it, if it isn't confirmed in time. Also
+// follows changes to the stored baud rate, i.e. restoring defaults, without a rollback.
+// NOTE: Called from the main loop, when there are no complete lines left to execute.
+void serial_update_baud_rate()
+{
+  uint32_t baud;
+  if (serial_baud_pending) {
+    baud = serial_baud_pending;
+  } else if (serial_baud_rollback) {
+    if ((int32_t)(system_get_millis()-serial_baud_timeout) < 0) { return; }
+    baud = serial_baud_rollback;
+  } else if (settings.baud_rate != serial_baud_rate) {
+    baud = settings.baud_rate;
+  } else {
+    return;
+  }
+
+  // Wait for the TX buffer to drain, then for the last characters to shift out of the USART.
+  while (serial_get_tx_buffer_count()) {
+    if (sys_rt_exec_state & EXEC_RESET) { return; } // Retried on the next call.
+  }
+  delay_us(20000000/serial_baud_rate); // Two character times.
+
+  if (serial_baud_pending) {
+    serial_baud_pending = 0;
+    serial_baud_rollback = serial_baud_rate;
+    serial_baud_timeout = system_get_millis() + (uint32_t)(1000.0*SERIAL_BAUD_ROLLBACK_TIMEOUT);
+    serial_set_baud_rate(baud);
+  } else if (serial_baud_rollback) {
+    serial_baud_rollback = 0;
+    serial_set_baud_rate(baud);
+    report_feedback_message(MESSAGE_BAUD_RATE_RESTORED); // Sent at the restored baud rate.
+  } else {
+    serial_set_baud_rate(baud);
+  }
+  serial_reset_read_buffer(); // Discard any characters garbled by the switch.
+}
+
+
+// Confirms a pending baud rate change and stores it in EEPROM. Called by the main loop upon
+// receiving a valid line.
+void serial_confirm_baud_rate()
+{
+  if (serial_baud_rollback) {
+    serial_baud_rollback = 0;
+    settings.baud_rate = serial_baud_rate;
+    write_global_settings();
+  }
+}
+#endif
+
+
+void serial_init()
+{
+  // Set baud rate
+  #ifdef ENABLE_BAUD_RATE_SETTING
+    serial_set_baud_rate(BAUD_RATE);
+  #else
+    #if BAUD_RATE < 57600
+      uint16_t UBRR0_value = ((F_CPU / (8L * BAUD_RATE)) - 1)/2 ;
+      UCSR0A &= ~(1 << U2X0); // baud doubler off  - Only needed on Uno XXX
+    #else
+      uint16_t UBRR0_value = ((F_CPU / (4L * BAUD_RATE)) - 1)/2;
+      UCSR0A |= (1 << U2X0);  // baud doubler on for high baud rates, i.e. 115200
+    #endif
+    UBRR0H = UBRR0_value >> 8;
+    UBRR0L = UBRR0_value;
+  #endif
+
+  #ifdef ENABLE_SERIAL_FLOW_CONTROL
+    FLOW_CONTROL_DDR |= (1<<FLOW_CONTROL_BIT); // Configure as output pin
+    FLOW_CONTROL_PORT &= ~(1<<FLOW_CONTROL_BIT); // Assert active-low RTS. Ready to receive.
+  #endif
 
   // enable rx, tx, and interrupt on complete reception of a byte
   UCSR0B |= (1<<RXEN0 | 1<<TXEN0 | 1<<RXCIE0);
@@ -88,10 +224,18 @@ void serial_write(uint8_t data) {
   uint8_t next_head = serial_tx_buffer_head + 1;
   if (next_head == TX_RING_BUFFER) { next_head = 0; }
 
-  // Wait until there is space in the buffer
+  // Wait until there is space in the buffer. Long reports, like '$$' or '$#', can take tens of
+  // milliseconds to transmit. While in motion, keep the step segment buffer fed meanwhile, so it
+  // doesn't starve and stall the machine. Other realtime commands are executed after the report,
+  // since they may print as well.
+  static uint8_t serial_write_prep_busy = false;
   while (next_head == serial_tx_buffer_tail) {
-    // TODO: Restructure st_prep_buffer() calls to be executed here during a long print.
     if (sys_rt_exec_state & EXEC_RESET) { return; } // Only check for abort to avoid an endless loop.
+    if ((sys.state & (STATE_CYCLE | STATE_HOLD | STATE_JOG)) && !serial_write_prep_busy) {
+      serial_write_prep_busy = true; // Guard against reentry, in case of a debug print.
+      st_prep_buffer();
+      serial_write_prep_busy = false;
+    }
   }
 
   // Store data and advance head
@@ -125,15 +269,25 @@ ISR(SERIAL_UDRE)
 // Fetches the first byte in the serial read buffer. Called by main program.
 uint8_t serial_read()
 {
-  uint8_t tail = serial_rx_buffer_tail; // Temporary serial_rx_buffer_tail (to optimize for volatile)
-  if (serial_rx_buffer_head == tail) {
+  serial_rx_index_t tail = serial_rx_buffer_tail; // Temporary serial_rx_buffer_tail (to optimize for volatile)
+  if (serial_rx_get_head() == tail) {
     return SERIAL_NO_DATA;
   } else {
     uint8_t data = serial_rx_buffer[tail];
 
     tail++;
     if (tail == RX_RING_BUFFER) { tail = 0; }
-    serial_rx_buffer_tail = tail;
+    serial_rx_set_tail(tail);
+
+    #ifdef ENABLE_SERIAL_FLOW_CONTROL
+      // Re-assert RTS once the buffer has drained below the low watermark. The RX ISR only ever
+      // de-asserts it, so the host is never released before enough room is available.
+      if (FLOW_CONTROL_PORT & (1<<FLOW_CONTROL_BIT)) {
+        if (serial_get_rx_buffer_count() <= RX_BUFFER_FLOW_CONTROL_LOW) {
+          FLOW_CONTROL_PORT &= ~(1<<FLOW_CONTROL_BIT);
+        }
+      }
+    #endif
 
     return data;
   }
@@ -143,7 +297,7 @@ uint8_t serial_read()
 ISR(SERIAL_RX)
 {
   uint8_t data = UDR0;
-  uint8_t next_head;
+  serial_rx_index_t next_head;
 
   // Pick off realtime command characters directly from the serial stream. These characters are
   // not passed into the main buffer, but these set system state flag bits for realtime execution.
@@ -156,6 +310,9 @@ ISR(SERIAL_RX)
       if (data > 0x7F) { // Real-time control characters are extended ACSII only.
         switch(data) {
           case CMD_SAFETY_DOOR:   system_set_exec_state_flag(EXEC_SAFETY_DOOR); break; // Set as true
+          #ifdef ENABLE_BINARY_STATUS_REPORT
+            case CMD_BINARY_STATUS_REPORT: system_set_exec_report_flag(EXEC_BINARY_STATUS_REPORT); break;
+          #endif
           case CMD_JOG_CANCEL:   
             if (sys.state & STATE_JOG) { // Block all other states from invoking motion cancel.
               system_set_exec_state_flag(EXEC_MOTION_CANCEL); 
@@ -189,9 +346,23 @@ ISR(SERIAL_RX)
         if (next_head == RX_RING_BUFFER) { next_head = 0; }
 
         // Write data to buffer unless it is full.
-        if (next_head != serial_rx_buffer_tail) {
+        serial_rx_index_t tail = serial_rx_buffer_tail; // Copy to limit multiple calls to volatile
+        if (next_head != tail) {
           serial_rx_buffer[serial_rx_buffer_head] = data;
           serial_rx_buffer_head = next_head;
+          #ifdef ENABLE_SERIAL_FLOW_CONTROL
+            // De-assert RTS to stop the host at the high watermark. The remaining space absorbs any
+            // characters already in flight in the host UART or USB-serial bridge.
+            serial_rx_index_t rx_count = next_head-tail;
+            if (next_head < tail) { rx_count += RX_RING_BUFFER; }
+            if (rx_count >= RX_BUFFER_FLOW_CONTROL_HIGH) {
+              FLOW_CONTROL_PORT |= (1<<FLOW_CONTROL_BIT);
+            }
+          #endif
+          #ifdef ENABLE_PERF_COUNTERS
+            if (++next_head == RX_RING_BUFFER) { next_head = 0; }
+            if (next_head == tail) { sys_perf.rx_full++; } // Buffer just filled up.
+          #endif
         }
       }
   }
@@ -200,5 +371,8 @@ ISR(SERIAL_RX)
 
 void serial_reset_read_buffer()
 {
-  serial_rx_buffer_tail = serial_rx_buffer_head;
+  serial_rx_set_tail(serial_rx_get_head());
+  #ifdef ENABLE_SERIAL_FLOW_CONTROL
+    FLOW_CONTROL_PORT &= ~(1<<FLOW_CONTROL_BIT); // Buffer empty. Release the host.
+  #endif
 }
@@ -36,9 +36,35 @@
 
 #define SERIAL_NO_DATA 0xff
 
+// Serial RX ring buffer index type. Buffers larger than 254 bytes, typically only on processors
+// with more RAM, require 16-bit indexing. Since the AVR is an 8-bit processor, these indices are
+// no longer read or written in a single instruction and are accessed atomically in serial.c.
+#if (RX_BUFFER_SIZE > 254)
+  typedef uint16_t serial_rx_index_t;
+#else
+  typedef uint8_t serial_rx_index_t;
+#endif
+
 
 void serial_init();
 
+#ifdef ENABLE_BAUD_RATE_SETTING
+  // Returns if the baud rate is supported by the '$' baud rate setting.
+  uint8_t serial_baud_rate_is_valid(uint32_t baud);
+
+  // Sets the USART baud rate immediately. Any data being transmitted is corrupted.
+  void serial_set_baud_rate(uint32_t baud);
+
+  // Requests a baud rate change, applied after the current response is sent.
+  void serial_request_baud_rate(uint32_t baud);
+
+  // Applies requested baud rate changes and reverts unconfirmed ones. Called by the main loop.
+  void serial_update_baud_rate();
+
+  // Confirms and stores a pending baud rate change upon receiving a valid line.
+  void serial_confirm_baud_rate();
+#endif
+
 // Writes one byte to the TX serial buffer. Called by main program.
 void serial_write(uint8_t data);
 
@@ -49,11 +75,11 @@ uint8_t serial_read();
 void serial_reset_read_buffer();
 
 // Returns the number of bytes available in the RX serial buffer.
-uint8_t serial_get_rx_buffer_available();
+serial_rx_index_t serial_get_rx_buffer_available();
 
 // Returns the number of bytes used in the RX serial buffer.
-// NOTE: Deprecated. Not used unless classic status reports are enabled in config.h.
-uint8_t serial_get_rx_buffer_count();
+// NOTE: Only used by the optional RTS flow control to check the low watermark.
+serial_rx_index_t serial_get_rx_buffer_count();
 
 // Returns the number of bytes used in the TX serial buffer.
 // NOTE: Not used except for debugging and ensuring no TX bottlenecks.
@@ -38,6 +38,8 @@ const __flash settings_t defaults = {\
     .homing_seek_rate = DEFAULT_HOMING_SEEK_RATE,
     .homing_debounce_delay = DEFAULT_HOMING_DEBOUNCE_DELAY,
     .homing_pulloff = DEFAULT_HOMING_PULLOFF,
+    .baud_rate = BAUD_RATE,
+    .status_report_interval = DEFAULT_STATUS_REPORT_INTERVAL,
     .flags = (DEFAULT_REPORT_INCHES << BIT_REPORT_INCHES) | \
              (DEFAULT_LASER_MODE << BIT_LASER_MODE) | \
              (DEFAULT_INVERT_ST_ENABLE << BIT_INVERT_ST_ENABLE) | \
@@ -105,6 +107,9 @@ void settings_restore(uint8_t restore_flag) {
   if (restore_flag & SETTINGS_RESTORE_DEFAULTS) {    
     settings = defaults;
     write_global_settings();
+    #ifdef REPORT_POSITION_FIXED_POINT
+      report_update_position_scale();
+    #endif
   }
 
   if (restore_flag & SETTINGS_RESTORE_PARAMETERS) {
@@ -294,11 +299,27 @@ uint8_t settings_store_global_setting(uint8_t parameter, float value) {
           return(STATUS_SETTING_DISABLED_LASER);
         #endif
         break;
+      #ifdef ENABLE_BAUD_RATE_SETTING
+        case 40:
+          // Baud rate is switched after the response is sent and only stored once confirmed.
+          if (!serial_baud_rate_is_valid((uint32_t)value)) { return(STATUS_SETTING_INVALID_BAUD_RATE); }
+          serial_request_baud_rate((uint32_t)value);
+          return(STATUS_OK);
+      #endif
+      #ifdef ENABLE_AUTO_STATUS_REPORT
+        case 41:
+          if (value > 65535.0) { return(STATUS_INVALID_STATEMENT); }
+          settings.status_report_interval = trunc(value);
+          break;
+      #endif
       default:
         return(STATUS_INVALID_STATEMENT);
     }
   }
   write_global_settings();
+  #ifdef REPORT_POSITION_FIXED_POINT
+    report_update_position_scale(); // Steps/mm or report inches may have changed.
+  #endif
   return(STATUS_OK);
 }
 
@@ -310,6 +331,9 @@ void settings_init() {
     settings_restore(SETTINGS_RESTORE_ALL); // Force restore all EEPROM data.
     report_grbl_settings();
   }
+  #ifdef REPORT_POSITION_FIXED_POINT
+    report_update_position_scale();
+  #endif
 }
 
 
@@ -27,7 +27,7 @@
 
 // Version of the EEPROM data. Will be used to migrate existing data from older versions of Grbl
 // when firmware is upgraded. Always stored in byte 0 of eeprom
-#define SETTINGS_VERSION 10  // NOTE: Check settings_reset() when moving to next version.
+#define SETTINGS_VERSION 12  // NOTE: Check settings_reset() when moving to next version.
 
 // Define bit flag masks for the boolean settings in settings.flag.
 #define BIT_REPORT_INCHES      0
@@ -110,9 +110,15 @@ typedef struct {
   float homing_seek_rate;
   uint16_t homing_debounce_delay;
   float homing_pulloff;
+
+  uint32_t baud_rate;
+  uint16_t status_report_interval; // Automatic status report interval in milliseconds. Zero disables.
 } settings_t;
 extern settings_t settings;
 
+// Writes the global settings struct to EEPROM. Used directly for settings confirmed after the fact.
+void write_global_settings();
+
 // Initialize the configuration subsystem (load settings from EEPROM)
 void settings_init();
 
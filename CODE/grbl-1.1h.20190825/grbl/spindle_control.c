@@ -24,11 +24,24 @@
 
 #ifdef VARIABLE_SPINDLE
   static float pwm_gradient; // Precalulated value to speed up rpm to PWM conversions.
+  #ifdef ENABLE_SPINDLE_PWM_TABLE
+    static uint8_t pwm_table[SPINDLE_PWM_TABLE_SIZE]; // PWM values at evenly spaced rpm of the model.
+    static float pwm_table_gradient; // Fixed-point 8.8 table index per rpm.
+    static void spindle_build_pwm_table();
+  #endif
+#endif
+
+#ifdef SPINDLE_SPINUP_OVERLAP
+  static uint8_t spindle_spinup_pending; // True until feed motions have waited for the spin-up.
+  static uint32_t spindle_spinup_start;  // Millisecond tick, when the spindle started or reversed.
 #endif
 
 
 void spindle_init()
 {
+  #ifdef SPINDLE_SPINUP_OVERLAP
+    spindle_spinup_pending = false;
+  #endif
   #ifdef VARIABLE_SPINDLE
     // Configure variable spindle PWM and enable pin, if requried. On the Uno, PWM and enable are
     // combined unless configured otherwise.
@@ -43,6 +56,9 @@ void spindle_init()
       #endif
     #endif
     pwm_gradient = SPINDLE_PWM_RANGE/(settings.rpm_max-settings.rpm_min);
+    #ifdef ENABLE_SPINDLE_PWM_TABLE
+      spindle_build_pwm_table();
+    #endif
   #else
     SPINDLE_ENABLE_DDR |= (1<<SPINDLE_ENABLE_BIT); // Configure as output pin.
     #ifndef ENABLE_DUAL_AXIS
@@ -144,78 +160,100 @@ void spindle_stop()
 
 
   #ifdef ENABLE_PIECEWISE_LINEAR_SPINDLE
-  
-    // Called by spindle_set_state() and step segment generator. Keep routine small and efficient.
-    uint8_t spindle_compute_pwm_value(float rpm) // 328p PWM register is 8-bit.
+    #define SPINDLE_MODEL_RPM_MAX RPM_MAX
+    #define SPINDLE_MODEL_RPM_MIN RPM_MIN
+
+    // Computes the PWM value of an rpm strictly between RPM_MIN and RPM_MAX with the piecewise
+    // linear fit model.
+    static uint8_t spindle_model_pwm_value(float rpm)
     {
-      uint8_t pwm_value;
-      rpm *= (0.010*sys.spindle_speed_ovr); // Scale by spindle speed override value.
-      // Calculate PWM register value based on rpm max/min settings and programmed rpm.
-      if ((settings.rpm_min >= settings.rpm_max) || (rpm >= RPM_MAX)) {
-        rpm = RPM_MAX;
-        pwm_value = SPINDLE_PWM_MAX_VALUE;
-      } else if (rpm <= RPM_MIN) {
-        if (rpm == 0.0) { // S0 disables spindle
-          pwm_value = SPINDLE_PWM_OFF_VALUE;
-        } else {
-          rpm = RPM_MIN;
-          pwm_value = SPINDLE_PWM_MIN_VALUE;
-        }
-      } else {
-        // Compute intermediate PWM value with linear spindle speed model via piecewise linear fit model.
-        #if (N_PIECES > 3)
-          if (rpm > RPM_POINT34) {
-            pwm_value = floor(RPM_LINE_A4*rpm - RPM_LINE_B4);
-          } else 
-        #endif
-        #if (N_PIECES > 2)
-          if (rpm > RPM_POINT23) {
-            pwm_value = floor(RPM_LINE_A3*rpm - RPM_LINE_B3);
-          } else 
-        #endif
-        #if (N_PIECES > 1)
-          if (rpm > RPM_POINT12) {
-            pwm_value = floor(RPM_LINE_A2*rpm - RPM_LINE_B2);
-          } else 
-        #endif
-        {
-          pwm_value = floor(RPM_LINE_A1*rpm - RPM_LINE_B1);
-        }
+      #if (N_PIECES > 3)
+        if (rpm > RPM_POINT34) {
+          return(floor(RPM_LINE_A4*rpm - RPM_LINE_B4));
+        } else 
+      #endif
+      #if (N_PIECES > 2)
+        if (rpm > RPM_POINT23) {
+          return(floor(RPM_LINE_A3*rpm - RPM_LINE_B3));
+        } else 
+      #endif
+      #if (N_PIECES > 1)
+        if (rpm > RPM_POINT12) {
+          return(floor(RPM_LINE_A2*rpm - RPM_LINE_B2));
+        } else 
+      #endif
+      {
+        return(floor(RPM_LINE_A1*rpm - RPM_LINE_B1));
       }
-      sys.spindle_speed = rpm;
-      return(pwm_value);
     }
-    
-  #else 
-  
-    // Called by spindle_set_state() and step segment generator. Keep routine small and efficient.
-    uint8_t spindle_compute_pwm_value(float rpm) // 328p PWM register is 8-bit.
+  #else
+    #define SPINDLE_MODEL_RPM_MAX settings.rpm_max
+    #define SPINDLE_MODEL_RPM_MIN settings.rpm_min
+
+    // Computes the PWM value of an rpm strictly between the $31 and $30 settings with the linear
+    // spindle speed model.
+    // NOTE: A nonlinear model could be installed here, if required, but keep it VERY light-weight.
+    static uint8_t spindle_model_pwm_value(float rpm)
     {
-      uint8_t pwm_value;
-      rpm *= (0.010*sys.spindle_speed_ovr); // Scale by spindle speed override value.
-      // Calculate PWM register value based on rpm max/min settings and programmed rpm.
-      if ((settings.rpm_min >= settings.rpm_max) || (rpm >= settings.rpm_max)) {
-        // No PWM range possible. Set simple on/off spindle control pin state.
-        sys.spindle_speed = settings.rpm_max;
-        pwm_value = SPINDLE_PWM_MAX_VALUE;
-      } else if (rpm <= settings.rpm_min) {
-        if (rpm == 0.0) { // S0 disables spindle
-          sys.spindle_speed = 0.0;
-          pwm_value = SPINDLE_PWM_OFF_VALUE;
-        } else { // Set minimum PWM output
-          sys.spindle_speed = settings.rpm_min;
-          pwm_value = SPINDLE_PWM_MIN_VALUE;
-        }
-      } else { 
-        // Compute intermediate PWM value with linear spindle speed model.
-        // NOTE: A nonlinear model could be installed here, if required, but keep it VERY light-weight.
-        sys.spindle_speed = rpm;
-        pwm_value = floor((rpm-settings.rpm_min)*pwm_gradient) + SPINDLE_PWM_MIN_VALUE;
+      return(floor((rpm-settings.rpm_min)*pwm_gradient) + SPINDLE_PWM_MIN_VALUE);
+    }
+  #endif
+
+
+  #ifdef ENABLE_SPINDLE_PWM_TABLE
+    // Builds the PWM lookup table from the spindle model at evenly spaced rpm. Called by
+    // spindle_init() upon settings load or rpm settings change.
+    static void spindle_build_pwm_table()
+    {
+      if (SPINDLE_MODEL_RPM_MIN >= SPINDLE_MODEL_RPM_MAX) { return; } // Not used. No PWM range.
+      float rpm_increment = (SPINDLE_MODEL_RPM_MAX-SPINDLE_MODEL_RPM_MIN)/(SPINDLE_PWM_TABLE_SIZE-1);
+      uint8_t idx;
+      pwm_table[0] = SPINDLE_PWM_MIN_VALUE;
+      for (idx=1; idx<(SPINDLE_PWM_TABLE_SIZE-1); idx++) {
+        pwm_table[idx] = spindle_model_pwm_value(SPINDLE_MODEL_RPM_MIN+idx*rpm_increment);
       }
-      return(pwm_value);
+      pwm_table[SPINDLE_PWM_TABLE_SIZE-1] = SPINDLE_PWM_MAX_VALUE;
+      pwm_table_gradient = 256.0/rpm_increment;
     }
-    
   #endif
+
+
+  // Called by spindle_set_state() and step segment generator. Keep routine small and efficient.
+  uint8_t spindle_compute_pwm_value(float rpm) // 328p PWM register is 8-bit.
+  {
+    uint8_t pwm_value;
+    rpm *= (0.010*sys.spindle_speed_ovr); // Scale by spindle speed override value.
+    // Calculate PWM register value based on rpm max/min settings and programmed rpm.
+    if ((settings.rpm_min >= settings.rpm_max) || (rpm >= SPINDLE_MODEL_RPM_MAX)) {
+      // No PWM range possible. Set simple on/off spindle control pin state.
+      rpm = SPINDLE_MODEL_RPM_MAX;
+      pwm_value = SPINDLE_PWM_MAX_VALUE;
+    } else if (rpm <= SPINDLE_MODEL_RPM_MIN) {
+      if (rpm == 0.0) { // S0 disables spindle
+        pwm_value = SPINDLE_PWM_OFF_VALUE;
+      } else { // Set minimum PWM output
+        rpm = SPINDLE_MODEL_RPM_MIN;
+        pwm_value = SPINDLE_PWM_MIN_VALUE;
+      }
+    } else {
+      #ifdef ENABLE_SPINDLE_PWM_TABLE
+        // Look up the PWM value with a fixed-point 8.8 table index, interpolating between entries.
+        // NOTE: Float rounding may index the last entry just below max rpm. Nothing to interpolate.
+        uint16_t table_index = (rpm-SPINDLE_MODEL_RPM_MIN)*pwm_table_gradient;
+        uint8_t idx = table_index >> 8;
+        if (idx >= (SPINDLE_PWM_TABLE_SIZE-1)) {
+          pwm_value = pwm_table[SPINDLE_PWM_TABLE_SIZE-1];
+        } else {
+          pwm_value = pwm_table[idx] + (((pwm_table[idx+1]-pwm_table[idx])*(table_index & 0xFF)) >> 8);
+        }
+      #else
+        // Compute intermediate PWM value with the spindle speed model.
+        pwm_value = spindle_model_pwm_value(rpm);
+      #endif
+    }
+    sys.spindle_speed = rpm;
+    return(pwm_value);
+  }
 #endif
 
 
@@ -271,12 +309,40 @@ void spindle_stop()
 }
 
 
+#ifdef SPINDLE_SPINUP_OVERLAP
+  // Waits until the stepper has executed the queued feed motions, so the spindle changes while queued
+  // rapids keep moving. Starts the spin-up time, if the spindle starts or reverses. The parser modal
+  // state is the old one. M5 still empties the planner buffer, so the spindle keeps running through
+  // a queued retract.
+  static void spindle_spinup_sync(uint8_t state)
+  {
+    if (state == SPINDLE_DISABLE) {
+      protocol_buffer_synchronize();
+      spindle_spinup_pending = false;
+      return;
+    }
+    protocol_rapid_synchronize();
+    if (state != gc_state.modal.spindle) {
+      spindle_spinup_start = system_get_millis();
+      spindle_spinup_pending = true;
+    }
+  }
+#endif
+
+
 // G-code parser entry-point for setting spindle state. Forces a planner buffer sync and bails 
 // if an abort or check-mode is active.
 #ifdef VARIABLE_SPINDLE
   void spindle_sync(uint8_t state, float rpm)
   {
     if (sys.state == STATE_CHECK_MODE) { return; }
+    #ifdef SPINDLE_SPINUP_OVERLAP
+      if (bit_isfalse(settings.flags,BITFLAG_LASER_MODE)) {
+        spindle_spinup_sync(state);
+        spindle_set_state(state,rpm);
+        return;
+      }
+    #endif
     protocol_buffer_synchronize(); // Empty planner buffer to ensure spindle is set when programmed.
     spindle_set_state(state,rpm);
   }
@@ -284,7 +350,27 @@ void spindle_stop()
   void _spindle_sync(uint8_t state)
   {
     if (sys.state == STATE_CHECK_MODE) { return; }
-    protocol_buffer_synchronize(); // Empty planner buffer to ensure spindle is set when programmed.
+    #ifdef SPINDLE_SPINUP_OVERLAP
+      spindle_spinup_sync(state);
+    #else
+      protocol_buffer_synchronize(); // Empty planner buffer to ensure spindle is set when programmed.
+    #endif
     _spindle_set_state(state);
   }
 #endif
+
+
+#ifdef SPINDLE_SPINUP_OVERLAP
+  // Holds a feed motion until the spindle has finished spinning up from the last M3/M4. Queued
+  // rapids keep executing in the meantime.
+  void spindle_spinup_synchronize()
+  {
+    if (!spindle_spinup_pending) { return; }
+    protocol_auto_cycle_start();
+    while ((system_get_millis()-spindle_spinup_start) < SPINDLE_SPINUP_TIME) {
+      protocol_execute_realtime();   // Check and execute run-time commands
+      if (sys.abort) { return; } // Check for system abort
+    }
+    spindle_spinup_pending = false;
+  }
+#endif
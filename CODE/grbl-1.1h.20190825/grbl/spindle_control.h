@@ -69,5 +69,10 @@ uint8_t spindle_get_state();
 // Stop and start spindle routines. Called by all spindle routines and stepper ISR.
 void spindle_stop();
 
+#ifdef SPINDLE_SPINUP_OVERLAP
+  // Holds a feed motion until the spindle has finished spinning up from the last M3/M4.
+  void spindle_spinup_synchronize();
+#endif
+
 
 #endif
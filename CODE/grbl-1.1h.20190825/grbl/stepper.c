@@ -73,6 +73,9 @@ typedef struct {
   #ifdef VARIABLE_SPINDLE
     uint8_t is_pwm_rate_adjusted; // Tracks motions that require constant laser power/rate
   #endif
+  #ifdef SPINDLE_SPINUP_OVERLAP
+    uint8_t is_rapid; // Tracks rapids, during which the spindle may change state.
+  #endif
 } st_block_t;
 static st_block_t st_block_buffer[SEGMENT_BUFFER_SIZE-1];
 
@@ -176,6 +179,17 @@ typedef struct {
     float inv_rate;    // Used by PWM laser mode to speed up segment calculations.
     uint8_t current_spindle_pwm; 
   #endif
+
+  #ifdef ENABLE_LASER_RASTER
+    uint16_t raster_pixels;    // Pixels of the raster block not yet reached by a segment.
+    float raster_mm_per_pixel; // Pixel pitch of the raster block (mm)
+    float raster_run_end;      // End of the current pixel run measured from end of block (mm)
+    uint8_t raster_power;      // Power of the current pixel run
+  #endif
+
+  #ifdef ENABLE_PERF_COUNTERS
+    float peak_speed;       // Highest segment exit speed of the block so far (mm/min)
+  #endif
 } st_prep_t;
 static st_prep_t prep;
 
@@ -391,6 +405,12 @@ ISR(TIMER1_COMPA_vect)
 
     } else {
       // Segment buffer empty. Shutdown.
+      #ifdef ENABLE_PERF_COUNTERS
+        // An underrun, if the segment generator didn't keep up with planned motions.
+        if (bit_isfalse(sys.step_control,STEP_CONTROL_END_MOTION) && (plan_get_current_block() != NULL)) {
+          sys_perf.underruns++;
+        }
+      #endif
       st_go_idle();
       #ifdef VARIABLE_SPINDLE
         // Ensure pwm is set properly upon completion of rate-controlled motion.
@@ -736,6 +756,10 @@ void st_prep_buffer()
           prep.current_speed = sqrt(pl_block->entry_speed_sqr);
         }
         
+        #ifdef SPINDLE_SPINUP_OVERLAP
+          st_prep_block->is_rapid = bit_istrue(pl_block->condition,PL_COND_FLAG_RAPID_MOTION);
+        #endif
+
         #ifdef VARIABLE_SPINDLE
           // Setup laser mode variables. PWM rate adjusted motions will always complete a motion with the
           // spindle off. 
@@ -748,6 +772,16 @@ void st_prep_buffer()
             }
           }
         #endif
+
+        #ifdef ENABLE_LASER_RASTER
+          // Setup raster pixel runs. The first segment loads the first run of the block.
+          // NOTE: Left untouched by non-raster blocks, so a parking motion may interrupt a raster block.
+          if (pl_block->raster_pixels) {
+            prep.raster_pixels = pl_block->raster_pixels;
+            prep.raster_mm_per_pixel = pl_block->millimeters/pl_block->raster_pixels;
+            prep.raster_run_end = pl_block->millimeters;
+          }
+        #endif
       }
 
 			/* ---------------------------------------------------------------------------------
@@ -875,6 +909,33 @@ void st_prep_buffer()
     float minimum_mm = mm_remaining-prep.req_mm_increment; // Guarantee at least one step.
     if (minimum_mm < 0.0) { minimum_mm = 0.0; }
 
+    #ifdef ENABLE_LASER_RASTER
+      if (pl_block->raster_pixels) {
+        // Load the pixel run under the segment start, allowing for half a step of round-off. Then,
+        // limit the segment time to end the segment on the next run boundary at the current speed.
+        // This is exact when cruising, which raster scanlines usually do. The segment is at least
+        // the minimum step distance long, so the step check below doesn't stretch it past the run.
+        raster_run_t *run;
+        while (prep.raster_pixels && ((mm_remaining-prep.raster_run_end) < 0.4*prep.req_mm_increment)) {
+          run = raster_get_current_run();
+          if (run == NULL) { prep.raster_pixels = 0; break; } // Should never happen.
+          prep.raster_power = run->power;
+          prep.raster_pixels -= run->pixels;
+          if (prep.raster_pixels) { prep.raster_run_end -= run->pixels*prep.raster_mm_per_pixel; }
+          else { prep.raster_run_end = 0.0; } // Last run ends with the block.
+          raster_discard_current_run();
+          bit_true(sys.step_control, STEP_CONTROL_UPDATE_SPINDLE_PWM);
+        }
+        if (prep.current_speed > 0.0) {
+          mm_var = max(mm_remaining-prep.raster_run_end, prep.req_mm_increment);
+          if (mm_var < prep.current_speed*dt_max) {
+            dt_max = mm_var/prep.current_speed;
+            time_var = dt_max;
+          }
+        }
+      }
+    #endif
+
     do {
       switch (prep.ramp_type) {
         case RAMP_DECEL_OVERRIDE:
@@ -950,6 +1011,10 @@ void st_prep_buffer()
       }
     } while (mm_remaining > prep.mm_complete); // **Complete** Exit loop. Profile complete.
 
+    #ifdef ENABLE_PERF_COUNTERS
+      if (prep.current_speed > prep.peak_speed) { prep.peak_speed = prep.current_speed; }
+    #endif
+
     #ifdef VARIABLE_SPINDLE
       /* -----------------------------------------------------------------------------------
         Compute spindle speed PWM output for step segment
@@ -958,6 +1023,9 @@ void st_prep_buffer()
       if (st_prep_block->is_pwm_rate_adjusted || (sys.step_control & STEP_CONTROL_UPDATE_SPINDLE_PWM)) {
         if (pl_block->condition & (PL_COND_FLAG_SPINDLE_CW | PL_COND_FLAG_SPINDLE_CCW)) {
           float rpm = pl_block->spindle_speed;
+          #ifdef ENABLE_LASER_RASTER
+            if (pl_block->raster_pixels) { rpm *= prep.raster_power*(1.0/RASTER_POWER_MAX); }
+          #endif
           // NOTE: Feed and rapid overrides are independent of PWM value and do not alter laser power/rate.        
           if (st_prep_block->is_pwm_rate_adjusted) { rpm *= (prep.current_speed * prep.inv_rate); }
           // If current_speed is zero, then may need to be rpm_min*(100/MAX_SPINDLE_SPEED_OVERRIDE)
@@ -1073,6 +1141,17 @@ void st_prep_buffer()
           bit_true(sys.step_control,STEP_CONTROL_END_MOTION);
           return;
         }
+        #ifdef ENABLE_PERF_COUNTERS
+          // Track the block peak speed against its programmed rate. Halving both sums keeps
+          // float precision and weighs the average towards recent blocks.
+          sys_perf.peak_speed_sum += prep.peak_speed;
+          sys_perf.programmed_sum += pl_block->programmed_rate;
+          if (sys_perf.programmed_sum > 1.0e6) {
+            sys_perf.peak_speed_sum *= 0.5;
+            sys_perf.programmed_sum *= 0.5;
+          }
+          prep.peak_speed = 0.0;
+        #endif
         pl_block = NULL; // Set pointer to indicate check and load next planner block.
         plan_discard_current_block();
       }
@@ -1082,6 +1161,22 @@ void st_prep_buffer()
 }
 
 
+#ifdef SPINDLE_SPINUP_OVERLAP
+  // Returns true, if the step segment buffer holds only segments of rapids or nothing. The segment
+  // at the buffer tail is the one executing, so a feed motion is complete, once this is true.
+  // NOTE: The stepper ISR only advances the tail, and the segments up to the head stay valid.
+  uint8_t st_check_rapid_segments()
+  {
+    uint8_t segment_index = segment_buffer_tail;
+    while (segment_index != segment_buffer_head) {
+      if (!st_block_buffer[segment_buffer[segment_index].st_block_index].is_rapid) { return(false); }
+      if ( ++segment_index == SEGMENT_BUFFER_SIZE) { segment_index = 0; }
+    }
+    return(true);
+  }
+#endif
+
+
 // Called by realtime status reporting to fetch the current speed being executed. This value
 // however is not exactly the current speed, but the speed computed in the last step segment
 // in the segment buffer. It will always be behind by up to the number of segment blocks (-1)
@@ -53,6 +53,11 @@ void st_prep_buffer();
 // Called by planner_recalculate() when the executing block is updated by the new plan.
 void st_update_plan_block_parameters();
 
+#ifdef SPINDLE_SPINUP_OVERLAP
+  // Returns true, if the step segment buffer holds no feed motion segments. It may still hold rapids.
+  uint8_t st_check_rapid_segments();
+#endif
+
 // Called by realtime status reporting if realtime rate reporting is enabled in config.h.
 float st_get_realtime_rate();
 
@@ -0,0 +1,356 @@
+/*
+  storage.c - SPI flash file storage and line source
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.h"
+
+#ifdef ENABLE_FILE_STORAGE
+
+// The flash is divided into N_STORAGE_FILES equal slots, each holding one file. The first page of a
+// slot is the file header, followed by the file data. Files hold the lines exactly as uploaded, each
+// terminated by a newline, and pass the same line filtering as the serial port when run. The header
+// name is written when the upload begins and the length when it is closed, so an interrupted upload
+// leaves no valid file behind.
+#define STORAGE_FILE_MAGIC 0x47 // 'G'
+#define STORAGE_LENGTH_UNSET 0xFFFFFFFF // Erased flash.
+typedef struct {
+  uint32_t length; // Must be first. Programmed at the start of the slot, when the upload is closed.
+  uint8_t magic;
+  char name[STORAGE_NAME_LENGTH+1];
+} storage_header_t;
+
+// JEDEC standard SPI NOR flash commands.
+#define FLASH_CMD_WRITE_ENABLE  0x06
+#define FLASH_CMD_READ_STATUS   0x05
+#define FLASH_CMD_READ_DATA     0x03
+#define FLASH_CMD_PAGE_PROGRAM  0x02
+#define FLASH_CMD_SECTOR_ERASE  0x20
+#define FLASH_CMD_JEDEC_ID      0x9F
+#define FLASH_STATUS_BUSY       bit(0)
+
+typedef struct {
+  uint8_t state;       // File storage state. See STORAGE_STATE defines.
+  uint32_t address;    // Flash address of the next character to read or write.
+  uint32_t end;        // Flash address of the end of the running file or the upload slot.
+} storage_t;
+static storage_t storage;
+
+
+// Low-level SPI flash access. The flash is bit-banged in 3-wire mode, where its DI and DO pins
+// share a single data pin. DO is connected through a 1k resistor to protect against contention
+// during bus turnaround. Slow compared to hardware SPI, but still several times faster than Grbl
+// can parse g-code, and it doesn't need the hardware SPI pins used by the limits and spindle.
+static void storage_select() { STORAGE_CS_PORT &= ~(1<<STORAGE_CS_BIT); }
+static void storage_deselect() { STORAGE_CS_PORT |= (1<<STORAGE_CS_BIT); }
+
+static void storage_spi_write(uint8_t data)
+{
+  uint8_t idx;
+  STORAGE_DIO_DDR |= (1<<STORAGE_DIO_BIT);
+  for (idx=0; idx<8; idx++) {
+    if (data & 0x80) { STORAGE_DIO_PORT |= (1<<STORAGE_DIO_BIT); }
+    else { STORAGE_DIO_PORT &= ~(1<<STORAGE_DIO_BIT); }
+    STORAGE_SCK_PORT |= (1<<STORAGE_SCK_BIT); // Flash samples on the rising edge.
+    data <<= 1;
+    STORAGE_SCK_PORT &= ~(1<<STORAGE_SCK_BIT);
+  }
+}
+
+static uint8_t storage_spi_read()
+{
+  uint8_t idx, data = 0;
+  STORAGE_DIO_DDR &= ~(1<<STORAGE_DIO_BIT);
+  STORAGE_DIO_PORT &= ~(1<<STORAGE_DIO_BIT); // No pull-up. Driven by the flash.
+  for (idx=0; idx<8; idx++) {
+    STORAGE_SCK_PORT |= (1<<STORAGE_SCK_BIT); // Flash shifts out on the falling edge.
+    data <<= 1;
+    if (STORAGE_DIO_PIN & (1<<STORAGE_DIO_BIT)) { data |= 1; }
+    STORAGE_SCK_PORT &= ~(1<<STORAGE_SCK_BIT);
+  }
+  return(data);
+}
+
+static void storage_flash_command(uint8_t command, uint32_t address)
+{
+  storage_select();
+  storage_spi_write(command);
+  storage_spi_write(address >> 16);
+  storage_spi_write(address >> 8);
+  storage_spi_write(address);
+}
+
+static void storage_flash_wait()
+{
+  storage_select();
+  storage_spi_write(FLASH_CMD_READ_STATUS);
+  while (storage_spi_read() & FLASH_STATUS_BUSY) { }
+  storage_deselect();
+}
+
+static void storage_flash_write_enable()
+{
+  storage_select();
+  storage_spi_write(FLASH_CMD_WRITE_ENABLE);
+  storage_deselect();
+}
+
+static void storage_flash_read(uint32_t address, char *data, uint8_t n)
+{
+  storage_flash_command(FLASH_CMD_READ_DATA, address);
+  while (n--) { *data++ = storage_spi_read(); }
+  storage_deselect();
+}
+
+// Programs data into erased flash. Must not cross a page boundary.
+static void storage_flash_program(uint32_t address, char *data, uint8_t n)
+{
+  storage_flash_write_enable();
+  storage_flash_command(FLASH_CMD_PAGE_PROGRAM, address);
+  while (n--) { storage_spi_write(*data++); }
+  storage_deselect();
+  storage_flash_wait();
+}
+
+static void storage_flash_erase_sector(uint32_t address)
+{
+  storage_flash_write_enable();
+  storage_flash_command(FLASH_CMD_SECTOR_ERASE, address);
+  storage_deselect();
+  storage_flash_wait(); // Typically 45msec.
+}
+
+// Returns true, if a flash chip responds with a valid JEDEC manufacturer ID.
+static uint8_t storage_flash_detect()
+{
+  storage_select();
+  storage_spi_write(FLASH_CMD_JEDEC_ID);
+  uint8_t id = storage_spi_read();
+  storage_deselect();
+  return((id != 0x00) && (id != 0xFF));
+}
+
+
+// Returns the slot index holding the named file, or N_STORAGE_FILES, if not found. If given,
+// the header of the file is stored in header.
+static uint8_t storage_find_file(char *name, storage_header_t *header)
+{
+  storage_header_t slot_header;
+  uint8_t slot;
+  for (slot=0; slot<N_STORAGE_FILES; slot++) {
+    storage_flash_read(slot*STORAGE_SLOT_SIZE, (char*)&slot_header, sizeof(storage_header_t));
+    if ((slot_header.magic == STORAGE_FILE_MAGIC) && (slot_header.length != STORAGE_LENGTH_UNSET)) {
+      if (!strcmp(name, slot_header.name)) {
+        if (header) { memcpy(header, &slot_header, sizeof(storage_header_t)); }
+        break;
+      }
+    }
+  }
+  return(slot);
+}
+
+
+// Lists all stored files with their size in bytes.
+static void storage_list_files()
+{
+  storage_header_t header;
+  uint8_t slot;
+  for (slot=0; slot<N_STORAGE_FILES; slot++) {
+    storage_flash_read(slot*STORAGE_SLOT_SIZE, (char*)&header, sizeof(storage_header_t));
+    if ((header.magic == STORAGE_FILE_MAGIC) && (header.length != STORAGE_LENGTH_UNSET)) {
+      header.name[STORAGE_NAME_LENGTH] = 0; // Terminate in case of corruption.
+      report_file_entry(header.name, header.length);
+    }
+  }
+}
+
+
+// Opens a file for upload into the slot of a file with the same name or the first free slot.
+static uint8_t storage_upload_file(char *name)
+{
+  if (!storage_flash_detect()) { return(STATUS_FILE_ERROR); }
+  uint8_t slot = storage_find_file(name, NULL);
+  if (slot == N_STORAGE_FILES) {
+    storage_header_t header;
+    for (slot=0; slot<N_STORAGE_FILES; slot++) {
+      storage_flash_read(slot*STORAGE_SLOT_SIZE, (char*)&header, sizeof(storage_header_t));
+      if ((header.magic != STORAGE_FILE_MAGIC) || (header.length == STORAGE_LENGTH_UNSET)) { break; }
+    }
+    if (slot == N_STORAGE_FILES) { return(STATUS_FILE_ERROR); } // No free slot.
+  }
+
+  // Erase the header sector and write the name. Data sectors are erased as the upload reaches them.
+  uint32_t address = slot*STORAGE_SLOT_SIZE;
+  storage_flash_erase_sector(address);
+  storage_header_t header;
+  memset(&header, 0xFF, sizeof(storage_header_t));
+  header.magic = STORAGE_FILE_MAGIC;
+  strcpy(header.name, name);
+  storage_flash_program(address, (char*)&header, sizeof(storage_header_t));
+
+  storage.address = address+STORAGE_PAGE_SIZE;
+  storage.end = address+STORAGE_SLOT_SIZE;
+  storage.state = STORAGE_STATE_UPLOAD;
+  return(STATUS_OK);
+}
+
+
+// Closes the uploaded file by writing its length into the header.
+uint8_t storage_close_file()
+{
+  if (storage.state != STORAGE_STATE_UPLOAD) { return(STATUS_FILE_ERROR); }
+  uint32_t address = storage.end-STORAGE_SLOT_SIZE;
+  uint32_t length = storage.address-(address+STORAGE_PAGE_SIZE);
+  storage_flash_program(address, (char*)&length, sizeof(uint32_t));
+  storage.state = STORAGE_STATE_IDLE;
+  return(STATUS_OK);
+}
+
+
+// Starts running a file. The flash is left selected in continuous read mode for the duration of the
+// run, so each character only costs a single byte transfer.
+static uint8_t storage_run_file(char *name)
+{
+  if (sys.state != STATE_IDLE) { return(STATUS_IDLE_ERROR); }
+  storage_header_t header;
+  uint8_t slot = storage_find_file(name, &header);
+  if (slot == N_STORAGE_FILES) { return(STATUS_FILE_ERROR); }
+  storage.address = slot*STORAGE_SLOT_SIZE+STORAGE_PAGE_SIZE;
+  storage.end = storage.address+header.length;
+  storage.state = STORAGE_STATE_RUN;
+  storage_flash_command(FLASH_CMD_READ_DATA, storage.address);
+  return(STATUS_OK);
+}
+
+
+// Pauses the running file. Lines already read keep executing. The continuous read is ended, and
+// restarted at the same address upon resume.
+static uint8_t storage_pause_file()
+{
+  if (storage.state != STORAGE_STATE_RUN) { return(STATUS_FILE_ERROR); }
+  storage_deselect();
+  storage.state = STORAGE_STATE_PAUSE;
+  report_feedback_message(MESSAGE_FILE_PAUSED);
+  return(STATUS_OK);
+}
+
+
+static uint8_t storage_resume_file()
+{
+  if (storage.state != STORAGE_STATE_PAUSE) { return(STATUS_FILE_ERROR); }
+  storage.state = STORAGE_STATE_RUN;
+  storage_flash_command(FLASH_CMD_READ_DATA, storage.address);
+  return(STATUS_OK);
+}
+
+
+// Deletes a file by erasing its header sector.
+static uint8_t storage_delete_file(char *name)
+{
+  uint8_t slot = storage_find_file(name, NULL);
+  if (slot == N_STORAGE_FILES) { return(STATUS_FILE_ERROR); }
+  storage_flash_erase_sector(slot*STORAGE_SLOT_SIZE);
+  return(STATUS_OK);
+}
+
+
+void storage_init()
+{
+  STORAGE_CS_DDR |= (1<<STORAGE_CS_BIT);
+  STORAGE_SCK_DDR |= (1<<STORAGE_SCK_BIT);
+  STORAGE_SCK_PORT &= ~(1<<STORAGE_SCK_BIT); // SPI mode 0. Clock idles low.
+  storage_deselect(); // Ends any continuous read of an aborted run.
+  storage.state = STORAGE_STATE_IDLE; // An aborted upload is left without a valid header.
+}
+
+
+uint8_t storage_get_state() { return(storage.state); }
+
+
+// Executes a '$F' file storage command. Lists files with '$F', uploads with '$FU=NAME' until
+// closed with '$FC', runs with '$FR=NAME', pauses with '$FP' and resumes with '$FR', and deletes
+// with '$FD=NAME'. Pause and resume work in any state, the others require IDLE or ALARM.
+uint8_t storage_execute_line(char *line)
+{
+  if (line[2] != 0) {
+    if (line[3] == 0) {
+      switch (line[2]) {
+        case 'C': return(storage_close_file());
+        case 'P': return(storage_pause_file());
+        case 'R': return(storage_resume_file());
+      }
+      return(STATUS_INVALID_STATEMENT);
+    }
+    if (line[3] != '=') { return(STATUS_INVALID_STATEMENT); }
+  }
+  if ( !(sys.state == STATE_IDLE || sys.state == STATE_ALARM) ) { return(STATUS_IDLE_ERROR); }
+  if (storage.state != STORAGE_STATE_IDLE) { return(STATUS_FILE_ERROR); }
+  if (line[2] == 0) {
+    storage_list_files();
+    return(STATUS_OK);
+  }
+  char *name = &line[4];
+  uint8_t length = strlen(name);
+  if ((length == 0) || (length > STORAGE_NAME_LENGTH)) { return(STATUS_INVALID_STATEMENT); }
+  switch (line[2]) {
+    case 'U': return(storage_upload_file(name));
+    case 'R': return(storage_run_file(name));
+    case 'D': return(storage_delete_file(name));
+  }
+  return(STATUS_INVALID_STATEMENT);
+}
+
+
+// Appends data to the uploaded file. Erases each sector as it is reached.
+uint8_t storage_write(char *data, uint8_t length)
+{
+  if (storage.state != STORAGE_STATE_UPLOAD) { return(STATUS_FILE_ERROR); }
+  if ((storage.address+length) > storage.end) { return(STATUS_FILE_ERROR); } // File full.
+  while (length) {
+    if ((storage.address % STORAGE_SECTOR_SIZE) == 0) { storage_flash_erase_sector(storage.address); }
+    uint16_t page_remaining = STORAGE_PAGE_SIZE-(storage.address % STORAGE_PAGE_SIZE);
+    uint8_t n = min(length, page_remaining);
+    storage_flash_program(storage.address, data, n);
+    storage.address += n;
+    data += n;
+    length -= n;
+  }
+  return(STATUS_OK);
+}
+
+
+uint8_t storage_read()
+{
+  if (storage.state != STORAGE_STATE_RUN) { return(SERIAL_NO_DATA); }
+  if (storage.address == storage.end) {
+    storage_deselect();
+    storage.state = STORAGE_STATE_IDLE;
+    report_feedback_message(MESSAGE_FILE_DONE);
+    return(SERIAL_NO_DATA);
+  }
+  storage.address++;
+  return(storage_spi_read());
+}
+
+
+void storage_stop()
+{
+  storage_deselect();
+  storage.state = STORAGE_STATE_IDLE;
+  report_feedback_message(MESSAGE_FILE_STOPPED);
+}
+
+#endif
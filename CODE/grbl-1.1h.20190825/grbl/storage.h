@@ -0,0 +1,58 @@
+/*
+  storage.h - SPI flash file storage and line source
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef storage_h
+#define storage_h
+
+
+// Define file storage states.
+#define STORAGE_STATE_IDLE    0 // Must be zero.
+#define STORAGE_STATE_UPLOAD  1 // Lines received are stored in the open file.
+#define STORAGE_STATE_RUN     2 // Lines are read from the open file, between those of the serial port.
+#define STORAGE_STATE_PAUSE   3 // Running file paused. Lines are read from the serial port only.
+
+// Define SPI flash geometry. Common to JEDEC-compliant SPI NOR flash, like the Winbond W25Q series.
+#define STORAGE_PAGE_SIZE     256
+#define STORAGE_SECTOR_SIZE   4096
+#define STORAGE_SLOT_SIZE     (STORAGE_FLASH_SIZE/N_STORAGE_FILES)
+#define STORAGE_NAME_LENGTH   12 // Max characters in a file name.
+
+
+// Initialize the file storage pins and close any open file. Called at every reset.
+void storage_init();
+
+// Returns the file storage state. See STORAGE_STATE defines.
+uint8_t storage_get_state();
+
+// Executes a '$F' file storage command line.
+uint8_t storage_execute_line(char *line);
+
+// Appends data to the file being uploaded.
+uint8_t storage_write(char *data, uint8_t length);
+
+// Closes the file being uploaded.
+uint8_t storage_close_file();
+
+// Fetches the next character of the running file. Returns SERIAL_NO_DATA at the end of the file,
+// and when no file is running. Used as a line source.
+uint8_t storage_read();
+
+// Stops the running file. Used upon a line error.
+void storage_stop();
+
+#endif
@@ -20,6 +20,14 @@
 
 #include "grbl.h"
 
+#ifdef ENABLE_SYSTEM_TICK
+  // System millisecond tick, driven by the Timer2 overflow interrupt. Each overflow takes slightly
+  // longer than a millisecond, so the remainder is accumulated in microseconds and carried over.
+  #define SYS_TICK_MICROSECONDS ((256UL*SYS_TICK_PRESCALER)/TICKS_PER_MICROSECOND)
+  static volatile uint32_t sys_tick_millis = 0;
+  static uint16_t sys_tick_micros = 0;
+#endif
+
 
 void system_init()
 {
@@ -31,7 +39,43 @@ void system_init()
   #endif
   CONTROL_PCMSK |= CONTROL_MASK;  // Enable specific pins of the Pin Change Interrupt
   PCICR |= (1 << CONTROL_INT);   // Enable Pin Change Interrupt
+
+  #ifdef ENABLE_SYSTEM_TICK
+    // Start the millisecond tick. With variable spindle enabled, spindle_init() configures Timer2
+    // for PWM with the same prescaler, so only the overflow interrupt needs to be enabled here.
+    #ifndef VARIABLE_SPINDLE
+      SYS_TICK_TCCRB_REGISTER = SYS_TICK_TCCRB_INIT_MASK; // Normal mode. Overflows at 256 counts.
+    #endif
+    SYS_TICK_TIMSK_REGISTER |= (1<<SYS_TICK_TOIE_BIT);
+  #endif
+}
+
+
+#ifdef ENABLE_SYSTEM_TICK
+// Returns the number of milliseconds since power-up. Wraps after ~49 days, so compare
+// timestamps by their difference only.
+uint32_t system_get_millis()
+{
+  uint8_t sreg = SREG;
+  cli();
+  uint32_t millis = sys_tick_millis;
+  SREG = sreg;
+  return(millis);
+}
+
+
+// Timer2 overflow interrupt. Advances the system millisecond tick.
+ISR(SYS_TICK_vect)
+{
+  uint32_t millis = sys_tick_millis + (SYS_TICK_MICROSECONDS/1000);
+  sys_tick_micros += (SYS_TICK_MICROSECONDS%1000);
+  if (sys_tick_micros >= 1000) {
+    sys_tick_micros -= 1000;
+    millis++;
+  }
+  sys_tick_millis = millis;
 }
+#endif
 
 
 // Returns control pin state as a uint8 bitfield. Each bit indicates the input pin state, where
@@ -130,9 +174,26 @@ uint8_t system_execute_line(char *line)
     case 'J' : // Jogging
       // Execute only if in IDLE or JOG states.
       if (sys.state != STATE_IDLE && sys.state != STATE_JOG) { return(STATUS_IDLE_ERROR); }
+      #ifdef ENABLE_VELOCITY_JOG
+        if ((line[2] == 'V') && (line[3] == '=')) { return(jog_velocity_execute(line)); }
+      #endif
       if(line[2] != '=') { return(STATUS_INVALID_STATEMENT); }
       return(gc_execute_line(line)); // NOTE: $J= is ignored inside g-code parser and used to detect jog motions.
       break;
+    #ifdef ENABLE_LASER_RASTER
+      case 'L' : // Raster scanline setup and pixels
+        return(raster_execute_line(line));
+    #endif
+    #ifdef ENABLE_FILE_STORAGE
+      case 'F' : // Stored files. Pause and resume in any state, everything else [IDLE/ALARM]
+        return(storage_execute_line(line));
+    #endif
+    #ifdef ENABLE_PERF_COUNTERS
+      case 'P' : // Prints performance counters
+        if ( line[2] != 0 ) { return(STATUS_INVALID_STATEMENT); }
+        report_perf_counters();
+        break;
+    #endif
     case '$': case 'G': case 'C': case 'X':
       if ( line[2] != 0 ) { return(STATUS_INVALID_STATEMENT); }
       switch( line[1] ) {
@@ -408,3 +469,19 @@ void system_clear_exec_accessory_overrides() {
   sys_rt_exec_accessory_override = 0;
   SREG = sreg;
 }
+
+#ifdef ENABLE_BINARY_STATUS_REPORT
+void system_set_exec_report_flag(uint8_t mask) {
+  uint8_t sreg = SREG;
+  cli();
+  sys_rt_exec_report |= (mask);
+  SREG = sreg;
+}
+
+void system_clear_exec_report_flag(uint8_t mask) {
+  uint8_t sreg = SREG;
+  cli();
+  sys_rt_exec_report &= ~(mask);
+  SREG = sreg;
+}
+#endif
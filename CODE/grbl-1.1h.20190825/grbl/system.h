@@ -37,6 +37,11 @@
 #define EXEC_MOTION_CANCEL  bit(6) // bitmask 01000000
 #define EXEC_SLEEP          bit(7) // bitmask 10000000
 
+// Report executor bit map. Realtime requests for reports in addition to the status report.
+#ifdef ENABLE_BINARY_STATUS_REPORT
+  #define EXEC_BINARY_STATUS_REPORT  bit(0)
+#endif
+
 // Alarm executor codes. Valid values (1-255). Zero is reserved.
 #define EXEC_ALARM_HARD_LIMIT                 1
 #define EXEC_ALARM_SOFT_LIMIT                 2
@@ -150,6 +155,20 @@ typedef struct {
 } system_t;
 extern system_t sys;
 
+#ifdef ENABLE_PERF_COUNTERS
+  // Runtime performance counters. Cleared upon reset.
+  typedef struct {
+    uint16_t rx_full;       // Serial RX buffer full events. The host is ahead of Grbl. (serial.c)
+    uint32_t lines;         // Lines executed. Reported as lines per second. (protocol.c)
+    uint16_t planner_empty; // Planner buffer emptied by the step segment generator. (planner.c)
+    uint16_t underruns;     // Step segment buffer ran empty with planned blocks left. (stepper.c)
+    uint16_t rejected;      // Zero-length blocks rejected by the planner. (planner.c)
+    float peak_speed_sum;   // Sum of executed block peak speeds. (mm/min) (stepper.c)
+    float programmed_sum;   // Sum of executed block programmed rates. (mm/min) (stepper.c)
+  } perf_t;
+  extern volatile perf_t sys_perf;
+#endif
+
 // NOTE: These position variables may need to be declared as volatiles, if problems arise.
 extern int32_t sys_position[N_AXIS];      // Real-time machine (aka home) position vector in steps.
 extern int32_t sys_probe_position[N_AXIS]; // Last probe position in machine coordinates and steps.
@@ -159,6 +178,9 @@ extern volatile uint8_t sys_rt_exec_state;   // Global realtime executor bitflag
 extern volatile uint8_t sys_rt_exec_alarm;   // Global realtime executor bitflag variable for setting various alarms.
 extern volatile uint8_t sys_rt_exec_motion_override; // Global realtime executor bitflag variable for motion-based overrides.
 extern volatile uint8_t sys_rt_exec_accessory_override; // Global realtime executor bitflag variable for spindle/coolant overrides.
+#ifdef ENABLE_BINARY_STATUS_REPORT
+  extern volatile uint8_t sys_rt_exec_report; // Global realtime executor bitflag variable for additional reports.
+#endif
 
 #ifdef DEBUG
   #define EXEC_DEBUG_REPORT  bit(0)
@@ -168,6 +190,14 @@ extern volatile uint8_t sys_rt_exec_accessory_override; // Global realtime execu
 // Initialize the serial protocol
 void system_init();
 
+// The millisecond system tick runs on Timer2, only when a feature needs it.
+#if defined(ENABLE_BAUD_RATE_SETTING) || defined(ENABLE_AUTO_STATUS_REPORT) || defined(ENABLE_PERF_COUNTERS) || defined(ENABLE_VELOCITY_JOG) || defined(SPINDLE_SPINUP_OVERLAP)
+  #define ENABLE_SYSTEM_TICK
+
+  // Returns the number of milliseconds since power-up.
+  uint32_t system_get_millis();
+#endif
+
 // Returns bitfield of control pin states, organized by CONTROL_PIN_INDEX. (1=triggered, 0=not triggered).
 uint8_t system_control_get_state();
 
@@ -207,6 +237,10 @@ void system_set_exec_motion_override_flag(uint8_t mask);
 void system_set_exec_accessory_override_flag(uint8_t mask);
 void system_clear_exec_motion_overrides();
 void system_clear_exec_accessory_overrides();
+#ifdef ENABLE_BINARY_STATUS_REPORT
+  void system_set_exec_report_flag(uint8_t mask);
+  void system_clear_exec_report_flag(uint8_t mask);
+#endif
 
 
 #endif
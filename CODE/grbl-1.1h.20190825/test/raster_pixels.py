@@ -0,0 +1,21 @@
+#!/usr/bin/env python
+"""\
+
+Encodes pixel powers with doc/script/raster_encode.py for test_raster
+
+Reads the pixel powers (0-31) from the file given as argument and
+writes a '$LS=' setup line and the '$L=' payload lines of a single
+scanline, as the encoder does for an image row.
+"""
+
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'doc', 'script'))
+import raster_encode
+
+with open(sys.argv[1]) as f:
+    pixels = [int(p) for p in f.read().split()]
+sys.stdout.write('$LS=P0.1F3000S1000\n')
+for line in raster_encode.payload_lines(raster_encode.encode_runs(pixels)):
+    sys.stdout.write(line + '\n')
@@ -0,0 +1,15 @@
+/*
+  interrupt.h - host stand-in, interrupt handlers are plain functions the tests call
+  Part of Grbl host tests
+*/
+
+#ifndef stub_avr_interrupt_h
+#define stub_avr_interrupt_h
+
+#define ISR(vector, ...) void vector(void)
+#define ISR_ALIASOF(vector)
+#define ISR_NOBLOCK
+#define sei()
+#define cli()
+
+#endif
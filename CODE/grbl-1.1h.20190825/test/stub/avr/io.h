@@ -0,0 +1,70 @@
+/*
+  io.h - host stand-in for the AVR register definitions
+  Part of Grbl host tests
+
+  Registers are plain variables, private to each translation unit. Bit numbers are the ATmega328P's.
+*/
+
+#ifndef stub_avr_io_h
+#define stub_avr_io_h
+
+#include <stdint.h>
+
+#define __AVR_ATmega328P__
+#define _BV(bit) (1 << (bit))
+#define __flash const
+
+#define STUB_REG8(name) static volatile uint8_t name __attribute__((unused));
+#define STUB_REG16(name) static volatile uint16_t name __attribute__((unused));
+
+STUB_REG8(SREG) STUB_REG8(MCUSR) STUB_REG8(WDTCSR) STUB_REG8(GPIOR0) STUB_REG8(GPIOR1)
+STUB_REG8(DDRB) STUB_REG8(DDRC) STUB_REG8(DDRD)
+STUB_REG8(PORTB) STUB_REG8(PORTC) STUB_REG8(PORTD)
+STUB_REG8(PINB) STUB_REG8(PINC) STUB_REG8(PIND)
+STUB_REG8(PCICR) STUB_REG8(PCMSK0) STUB_REG8(PCMSK1) STUB_REG8(PCMSK2)
+STUB_REG16(EEAR) STUB_REG8(EECR) STUB_REG8(EEDR)
+STUB_REG8(TCCR0A) STUB_REG8(TCCR0B) STUB_REG8(TCNT0) STUB_REG8(TIMSK0)
+STUB_REG8(TCCR1A) STUB_REG8(TCCR1B) STUB_REG16(TCNT1) STUB_REG16(OCR1A) STUB_REG8(TIMSK1) STUB_REG8(TIFR1)
+STUB_REG8(TCCR2A) STUB_REG8(TCCR2B) STUB_REG8(OCR2A) STUB_REG8(TIMSK2)
+STUB_REG8(UBRR0H) STUB_REG8(UBRR0L) STUB_REG8(UCSR0A) STUB_REG8(UCSR0B) STUB_REG8(UDR0)
+
+#define COM1A0 6
+#define COM1A1 7
+#define COM1B0 4
+#define COM1B1 5
+#define COM2A1 7
+#define CS01 1
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define CS22 2
+#define EERE 0
+#define EEWE 1
+#define EEMWE 2
+#define OCIE0A 1
+#define OCIE0B 2
+#define OCIE1A 1
+#define OCF1A 1
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define RXCIE0 7
+#define RXEN0 4
+#define TXEN0 3
+#define UDRIE0 5
+#define U2X0 1
+#define TOIE0 0
+#define TOIE2 0
+#define WGM10 0
+#define WGM11 1
+#define WGM12 3
+#define WGM13 4
+#define WGM20 0
+#define WGM21 1
+#define WDP0 0
+#define WDE 3
+#define WDRF 3
+#define WDCE 4
+#define WDIE 6
+
+#endif
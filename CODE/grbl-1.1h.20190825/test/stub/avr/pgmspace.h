@@ -0,0 +1,19 @@
+/*
+  pgmspace.h - host stand-in, program memory is ordinary memory
+  Part of Grbl host tests
+*/
+
+#ifndef stub_avr_pgmspace_h
+#define stub_avr_pgmspace_h
+
+#include <stdint.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_byte_near(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_word_near(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+
+#endif
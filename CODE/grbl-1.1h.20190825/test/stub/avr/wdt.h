@@ -0,0 +1,11 @@
+/*
+  wdt.h - host stand-in
+  Part of Grbl host tests
+*/
+
+#ifndef stub_avr_wdt_h
+#define stub_avr_wdt_h
+
+#define wdt_reset()
+
+#endif
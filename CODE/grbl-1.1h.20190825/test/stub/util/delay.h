@@ -0,0 +1,12 @@
+/*
+  delay.h - host stand-in, delays return right away
+  Part of Grbl host tests
+*/
+
+#ifndef stub_util_delay_h
+#define stub_util_delay_h
+
+static inline void _delay_ms(double ms) { (void)ms; }
+static inline void _delay_us(double us) { (void)us; }
+
+#endif
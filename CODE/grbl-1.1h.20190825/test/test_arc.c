@@ -0,0 +1,193 @@
+/*
+  test_arc.c - soft limit bounding box of arcs against sampled arc points
+  Part of Grbl host tests
+
+  mc_arc() checks the axis-aligned bounding box of a whole arc against the soft limits, before it
+  queues any segment. The box must match the extents of the exact arc, found by densely sampling
+  it in double precision, for random arcs in both directions, arcs starting or ending on an axis
+  direction and full circles. The queued segments must lie within the box. An arc leaving the
+  travel must raise the soft limit alarm with no segment queued.
+*/
+
+#include "grbl.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+system_t sys;
+settings_t settings;
+int32_t sys_position[N_AXIS];
+int32_t sys_probe_position[N_AXIS];
+volatile uint8_t sys_probe_state;
+volatile uint8_t sys_rt_exec_state;
+volatile uint8_t sys_rt_exec_alarm;
+
+static float box[2][N_AXIS];
+static uint8_t n_checks;
+static float travel_max;
+static uint8_t soft_limit;
+static float queued_min[N_AXIS], queued_max[N_AXIS];
+static uint16_t n_queued;
+
+// Records the box corners mc_arc() checks, the minimum first.
+uint8_t system_check_travel_limits(float *target)
+{
+  if (n_checks < 2) { memcpy(box[n_checks],target,sizeof(box[0])); }
+  n_checks++;
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    if (target[idx] > travel_max) { return(true); }
+  }
+  return(false);
+}
+
+void limits_soft_check(float *target) { if (system_check_travel_limits(target)) { soft_limit = true; } }
+
+uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
+{
+  (void)pl_data;
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    queued_min[idx] = min(queued_min[idx],target[idx]);
+    queued_max[idx] = max(queued_max[idx],target[idx]);
+  }
+  n_queued++;
+  return(PLAN_OK);
+}
+
+uint8_t plan_check_full_buffer() { return(false); }
+void protocol_execute_realtime() { }
+void protocol_auto_cycle_start() { }
+void protocol_buffer_synchronize() { }
+void system_set_exec_alarm(uint8_t code) { (void)code; }
+void system_set_exec_state_flag(uint8_t mask) { (void)mask; }
+void coolant_stop() { }
+void delay_sec(float seconds, uint8_t mode) { (void)seconds; (void)mode; }
+void gc_sync_position() { }
+void limits_disable() { }
+void limits_go_home(uint8_t cycle_mask) { (void)cycle_mask; }
+void limits_init() { }
+void plan_reset() { }
+void plan_sync_position() { }
+void probe_configure_invert_mask(uint8_t is_probe_away) { (void)is_probe_away; }
+uint8_t probe_get_state() { return(false); }
+void report_probe_parameters() { }
+void spindle_stop() { }
+void spindle_sync(uint8_t state, float rpm) { (void)state; (void)rpm; }
+void st_go_idle() { }
+void st_reset() { }
+
+
+#define N_SAMPLES 4000
+
+static uint32_t failed;
+
+// Runs an arc in the XY plane around (cx,cy) from angle a0 over the signed angle sweep, with a
+// helical Z travel, and compares the checked box with the sampled arc.
+static void check(const char *test, double cx, double cy, double r, double a0, double sweep, float z)
+{
+  float position[N_AXIS] = { cx+r*cos(a0), cy+r*sin(a0), 0.0 };
+  float target[N_AXIS] = { cx+r*cos(a0+sweep), cy+r*sin(a0+sweep), z };
+  float offset[N_AXIS] = { cx-position[X_AXIS], cy-position[Y_AXIS], 0.0 };
+  if (fabs(fabs(sweep)-2*M_PI) < 1e-9) { memcpy(target,position,sizeof(float)*2); }
+  uint8_t is_clockwise_arc = (sweep < 0.0);
+
+  // Sample the exact arc from the float end points, as mc_arc() sees them.
+  double s0 = atan2(position[Y_AXIS]-cy,position[X_AXIS]-cx);
+  double s1 = atan2(target[Y_AXIS]-cy,target[X_AXIS]-cx);
+  double travel = s1-s0;
+  if (is_clockwise_arc) { while (travel >= -ARC_ANGULAR_TRAVEL_EPSILON) { travel -= 2*M_PI; } }
+  else { while (travel <= ARC_ANGULAR_TRAVEL_EPSILON) { travel += 2*M_PI; } }
+  double sample_min[N_AXIS] = { position[X_AXIS], position[Y_AXIS], min(0.0,z) };
+  double sample_max[N_AXIS] = { position[X_AXIS], position[Y_AXIS], max(0.0,z) };
+  uint32_t i;
+  for (i=1; i<=N_SAMPLES; i++) {
+    double a = s0+travel*i/N_SAMPLES;
+    sample_min[X_AXIS] = fmin(sample_min[X_AXIS],cx+r*cos(a));
+    sample_max[X_AXIS] = fmax(sample_max[X_AXIS],cx+r*cos(a));
+    sample_min[Y_AXIS] = fmin(sample_min[Y_AXIS],cy+r*sin(a));
+    sample_max[Y_AXIS] = fmax(sample_max[Y_AXIS],cy+r*sin(a));
+  }
+
+  n_checks = 0;
+  n_queued = 0;
+  soft_limit = false;
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) { queued_min[idx] = SOME_LARGE_VALUE; queued_max[idx] = -SOME_LARGE_VALUE; }
+  plan_line_data_t pl_data = { 1000.0, 0.0, 0 };
+  mc_arc(target,&pl_data,position,offset,r,X_AXIS,Y_AXIS,Z_AXIS,is_clockwise_arc);
+
+  if ((n_checks != 2) || soft_limit) {
+    printf("test_arc: %s: %u box checks, soft limit %u\n",test,n_checks,soft_limit);
+    failed++;
+    return;
+  }
+  const double tolerance = 1e-5*(fabs(cx)+fabs(cy)+r)+1e-6;
+  for (idx=0; idx<N_AXIS; idx++) {
+    if ((fabs(box[0][idx]-sample_min[idx]) > tolerance) || (fabs(box[1][idx]-sample_max[idx]) > tolerance)) {
+      if (failed++ < 10) {
+        printf("test_arc: %s: axis %u box %.6f..%.6f, arc %.6f..%.6f (center %.3f,%.3f r %.3f from %.4f over %.4f rad)\n",
+               test,idx,box[0][idx],box[1][idx],sample_min[idx],sample_max[idx],cx,cy,r,a0,sweep);
+      }
+      return;
+    }
+    if ((queued_min[idx] < box[0][idx]-tolerance) || (queued_max[idx] > box[1][idx]+tolerance)) {
+      if (failed++ < 10) { printf("test_arc: %s: axis %u segment outside the box\n",test,idx); }
+      return;
+    }
+  }
+}
+
+static double random_range(double low, double high) { return(low+(high-low)*rand()/RAND_MAX); }
+
+int main()
+{
+  settings.flags = BITFLAG_SOFT_LIMIT_ENABLE;
+  settings.arc_tolerance = 0.002;
+  sys.state = STATE_IDLE;
+  travel_max = SOME_LARGE_VALUE;
+  srand(1);
+
+  uint32_t n;
+  for (n=0; n<20000; n++) {
+    double sweep = random_range(0.01,2*M_PI-0.01);
+    if (n & 1) { sweep = -sweep; }
+    check("random",random_range(-50.0,50.0),random_range(-50.0,50.0),random_range(0.5,50.0),
+          random_range(-M_PI,M_PI),sweep,random_range(-5.0,5.0));
+  }
+  // Start and end points on the axis directions, where the quadrant boundaries are.
+  uint8_t q0, q1;
+  for (q0=0; q0<4; q0++) {
+    for (q1=1; q1<8; q1++) {
+      check("axis ccw",3.0,-2.0,10.0,q0*M_PI_2,q1*M_PI_2-((q1 == 4) ? 1e-3 : 0.0),0.0);
+      check("axis cw",3.0,-2.0,10.0,q0*M_PI_2,-q1*M_PI_2+((q1 == 4) ? 1e-3 : 0.0),0.0);
+    }
+  }
+  // Full circles. The center and start point are on a binary grid, so the float offset gives back
+  // the center exactly, and mc_arc() sees a full turn rather than a tiny arc.
+  for (n=0; n<200; n++) {
+    double cx = round(random_range(-50.0,50.0)*64)/64;
+    double cy = round(random_range(-50.0,50.0)*64)/64;
+    double dx = round(random_range(-35.0,35.0)*1024)/1024;
+    double dy = round(random_range(-35.0,35.0)*1024)/1024;
+    if ((fabs(dx) < 0.5) && (fabs(dy) < 0.5)) { continue; }
+    check((n & 1) ? "circle cw" : "circle ccw",cx,cy,hypot(dx,dy),atan2(dy,dx),(n & 1) ? -2*M_PI : 2*M_PI,0.0);
+  }
+
+  // An arc bulging past the X travel alarms before any segment is queued, though its end points are inside.
+  travel_max = 7.5;
+  float position[N_AXIS] = { 6.928203, -8.0, 0.0 };
+  float target[N_AXIS] = { 6.928203, 0.0, 0.0 };
+  float offset[N_AXIS] = { -6.928203, 4.0, 0.0 };
+  plan_line_data_t pl_data = { 1000.0, 0.0, 0 };
+  n_checks = 0;
+  n_queued = 0;
+  soft_limit = false;
+  mc_arc(target,&pl_data,position,offset,8.0,X_AXIS,Y_AXIS,Z_AXIS,false);
+  if (!soft_limit || n_queued) {
+    printf("test_arc: soft limit: alarm %u, %u segments queued\n",soft_limit,n_queued);
+    failed++;
+  }
+
+  printf("test_arc: %lu failures\n",(unsigned long)failed);
+  return(failed ? 1 : 0);
+}
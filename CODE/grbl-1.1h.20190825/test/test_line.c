@@ -0,0 +1,155 @@
+/*
+  test_line.c - line assembly from a file-backed line source
+  Part of Grbl host tests
+
+  A file stands in for the serial port and the flash storage. The program is read as g-code lines,
+  once in one go and once trickling in, like serial data arriving between main loop passes. Then it
+  is uploaded in raw mode into a second file, the stand-in for a flash slot, and run from there. The
+  upload must keep every line as sent, and the run must yield the same lines as the direct reading.
+*/
+
+#include "grbl.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char program[] =
+  "g21 g90 (metric, absolute)\n"
+  "G0 X10.5 y-2 ; rapid\r\n"
+  "/M8\n"
+  "  \t\n"
+  "(a comment that runs well past the length of the line buffer, so the raw upload splits it into chunks)\n"
+  "G1 X1 Y2 Z3 F500 (feed) S1000 M3\n"
+  "$j=g91 x1 f100\n"
+  "G1 X1.000000000 Y2.000000000 Z3.000000000 A4.000000000 B5.000000000 C6.000000000 F1000.0000\n"
+  "g1x1y1(nested (text) continues)y2\n"
+  "M2\n";
+
+// Expected g-code lines, with the overflow flag. The CR LF end also yields an empty line.
+static const struct { const char *line; uint8_t overflow; } expected[] = {
+  { "G21G90", 0 }, { "G0X10.5Y-2", 0 }, { "", 0 }, { "M8", 0 }, { "", 0 }, { "", 0 },
+  { "G1X1Y2Z3F500S1000M3", 0 }, { "$J=G91X1F100", 0 }, { "", 1 }, { "G1X1Y1CONTINUES)Y2", 0 },
+  { "M2", 0 }
+};
+#define N_EXPECTED (sizeof(expected)/sizeof(expected[0]))
+
+
+static FILE *source_file;
+static uint16_t trickle;
+
+static uint8_t file_read()
+{
+  int c = fgetc(source_file);
+  return((c == EOF) ? SERIAL_NO_DATA : c);
+}
+
+// Runs dry every few characters, and continues with the next call.
+static uint8_t trickle_read()
+{
+  if ((++trickle % 7) == 0) { return(SERIAL_NO_DATA); }
+  return(file_read());
+}
+
+static const line_source_t file_source = { file_read };
+static const line_source_t trickle_source = { trickle_read };
+
+
+static uint16_t failed;
+
+static void fail(const char *test, const char *message, const char *line)
+{
+  failed++;
+  printf("test_line: %s: %s '%s'\n", test, message, line);
+}
+
+// Reads the g-code lines of the source file until it ends, and checks them. Empty lines are skipped
+// for a stored file, which keeps whitespace and comment lines but drops the empty ones.
+static void check_gcode(const char *test, const line_source_t *source, uint8_t skip_empty)
+{
+  char line[LINE_BUFFER_SIZE];
+  line_reader_t reader = { LINE_MODE_GCODE, 0, 0 };
+  uint8_t idx = 0;
+  uint8_t passes = 0;
+  while (!feof(source_file) || (passes++ < 1)) { // Another pass to see the end of the file.
+    uint8_t status;
+    while ((status = line_read(source, &reader, line)) != LINE_INCOMPLETE) {
+      if (status != LINE_COMPLETE) { fail(test, "chunk in g-code mode", line); }
+      if (skip_empty) {
+        while ((idx < N_EXPECTED) && !expected[idx].line[0] && !expected[idx].overflow) { idx++; }
+      }
+      if (skip_empty && !line[0] && !(reader.flags & LINE_FLAG_OVERFLOW)) {
+        // Whitespace or comment line of the stored file.
+      } else if (idx >= N_EXPECTED) {
+        fail(test, "extra line", line);
+      } else if (expected[idx++].overflow) {
+        if (!(reader.flags & LINE_FLAG_OVERFLOW)) { fail(test, "overflow not flagged", line); }
+      } else if ((reader.flags & LINE_FLAG_OVERFLOW) || strcmp(line, expected[idx-1].line)) {
+        fail(test, "unexpected line", line);
+      }
+      reader.flags = 0;
+      reader.char_counter = 0;
+    }
+  }
+  if (reader.flags || reader.char_counter) { fail(test, "partial line left", line); }
+  if (idx != N_EXPECTED) { fail(test, "missing lines", ""); }
+}
+
+
+// Uploads the program like the main loop does, into the stand-in flash slot.
+static void upload(FILE *slot)
+{
+  char line[LINE_BUFFER_SIZE];
+  line_reader_t reader = { LINE_MODE_RAW, 0, 0 };
+  uint8_t status;
+  while ((status = line_read(&file_source, &reader, line)) != LINE_INCOMPLETE) {
+    uint8_t length = strlen(line);
+    if (status == LINE_CHUNK) {
+      if (length != LINE_BUFFER_SIZE-1) { fail("upload", "short chunk", line); }
+      fwrite(line, 1, length, slot);
+      continue;
+    }
+    if (length || (reader.flags & LINE_FLAG_CONTINUED)) {
+      line[length++] = '\n';
+      fwrite(line, 1, length, slot);
+    }
+    reader.flags = 0;
+    reader.char_counter = 0;
+  }
+}
+
+
+int main()
+{
+  source_file = tmpfile();
+  fputs(program, source_file);
+
+  rewind(source_file);
+  check_gcode("file", &file_source, false);
+
+  rewind(source_file);
+  check_gcode("trickle", &trickle_source, false);
+
+  // Raw upload keeps every character, except line ends and the empty lines.
+  FILE *slot = tmpfile();
+  rewind(source_file);
+  upload(slot);
+  char stored[sizeof(program)], raw[sizeof(program)];
+  uint16_t n = 0;
+  const char *c;
+  for (c=program; *c; c++) {
+    if ((*c == '\r') || ((*c == '\n') && (n == 0 || raw[n-1] == '\n'))) { continue; }
+    raw[n++] = *c;
+  }
+  raw[n] = 0;
+  rewind(slot);
+  stored[fread(stored, 1, sizeof(stored)-1, slot)] = 0;
+  if (strcmp(stored, raw)) { fail("upload", "stored file differs", stored); }
+
+  // Running the stored file yields the lines of the program.
+  fclose(source_file);
+  source_file = slot;
+  rewind(source_file);
+  check_gcode("run", &file_source, true);
+
+  printf("test_line: %lu lines, %u failures\n", (unsigned long)N_EXPECTED, failed);
+  return(failed ? 1 : 0);
+}
@@ -0,0 +1,189 @@
+/*
+  test_print.c - status report positions from machine steps against the float formatting
+  Part of Grbl host tests
+
+  printCoord_Steps() must print exactly what the float path printed before, i.e. the mpos
+  conversion of system_convert_axis_steps_to_mpos(), less the work coordinate offset, through the
+  original printFloat(). The original is copied here verbatim as the reference.
+  A timing run then compares printCoord_Steps() with the steps/mm division and
+  printFloat_CoordValue() it replaces. It runs on the host CPU, so it only shows the relative
+  cost of the two paths, not their cycle counts on the AVR.
+*/
+
+#include "grbl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+settings_t settings;
+
+static char out[64];
+static uint8_t out_len;
+
+void serial_write(uint8_t data) { out[out_len++] = data; }
+
+
+static char ref[64];
+static uint8_t ref_len;
+
+static void ref_write(uint8_t data) { ref[ref_len++] = data; }
+
+// printFloat() before the fixed-point report path.
+static void ref_printFloat(float n, uint8_t decimal_places)
+{
+  if (n < 0) {
+    ref_write('-');
+    n = -n;
+  }
+
+  uint8_t decimals = decimal_places;
+  while (decimals >= 2) { // Quickly convert values expected to be E0 to E-4.
+    n *= 100;
+    decimals -= 2;
+  }
+  if (decimals) { n *= 10; }
+  n += 0.5; // Add rounding factor. Ensures carryover through entire value.
+
+  // Generate digits backwards and store in string.
+  unsigned char buf[13];
+  uint8_t i = 0;
+  uint32_t a = (long)n;
+  while(a > 0) {
+    buf[i++] = (a % 10) + '0'; // Get digit
+    a /= 10;
+  }
+  while (i < decimal_places) {
+     buf[i++] = '0'; // Fill in zeros to decimal point for (n < 1)
+  }
+  if (i == decimal_places) { // Fill in leading zero, if needed.
+    buf[i++] = '0';
+  }
+
+  // Print the generated string.
+  for (; i > 0; i--) {
+    if (i == decimal_places) { ref_write('.'); } // Insert decimal point in right place.
+    ref_write(buf[i-1]);
+  }
+}
+
+static void ref_position(int32_t steps, float steps_per_mm, float offset)
+{
+  float pos = steps/steps_per_mm;
+  pos -= offset;
+  if (bit_istrue(settings.flags,BITFLAG_REPORT_INCHES)) {
+    ref_printFloat(pos*INCH_PER_MM,N_DECIMAL_COORDVALUE_INCH);
+  } else {
+    ref_printFloat(pos,N_DECIMAL_COORDVALUE_MM);
+  }
+}
+
+
+static uint32_t checked, failed;
+
+static void check(coord_steps_t *coord, int32_t steps, float steps_per_mm, float offset)
+{
+  out_len = ref_len = 0;
+  printCoord_Steps(coord,steps,offset);
+  ref_position(steps,steps_per_mm,offset);
+  checked++;
+  if ((out_len != ref_len) || memcmp(out,ref,out_len)) {
+    if (failed++ < 10) {
+      printf("steps %ld, steps/mm %.6g, offset %.9g: %.*s, expected %.*s\n",(long)steps,
+             steps_per_mm,offset,out_len,out,ref_len,ref);
+    }
+  }
+}
+
+// Random float offset in mm, with a bias to the round values work offsets usually have.
+static float random_offset()
+{
+  switch (rand() % 4) {
+    case 0: return(0.0);
+    case 1: return((rand() % 20001 - 10000)/10.0);
+    case 2: return((rand() % 2000001 - 1000000)/1000.0);
+  }
+  return(ldexp((float)rand()/RAND_MAX - 0.5,rand() % 12));
+}
+
+static double seconds()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return(t.tv_sec+t.tv_nsec*1e-9);
+}
+
+// Formats work positions both ways, and prints the time per position. At 80 steps/mm, every odd
+// step is an exact half count, which printCoord_Steps() passes on to the float path.
+#define TIMING_POSITIONS 4096
+#define TIMING_ROUNDS 500
+
+static void timing(float steps_per_mm)
+{
+  const float offset[3] = { 12.5, -150.0, 3.175 };
+  static int32_t steps[TIMING_POSITIONS];
+  settings.flags = 0;
+  coord_steps_t coord[3];
+  uint32_t n;
+  for (n=0; n<3; n++) { printCoord_SetScale(&coord[n],steps_per_mm); }
+  srand(2);
+  for (n=0; n<TIMING_POSITIONS; n++) { steps[n] = rand() % 64001 - 32000; }
+
+  double t[2];
+  uint8_t pass;
+  for (pass=0; pass<2; pass++) {
+    double start = seconds();
+    uint32_t round;
+    for (round=0; round<TIMING_ROUNDS; round++) {
+      for (n=0; n<TIMING_POSITIONS; n++) {
+        uint8_t idx = n % 3;
+        out_len = 0;
+        if (pass == 0) {
+          printCoord_Steps(&coord[idx],steps[n],offset[idx]);
+        } else {
+          float mpos = steps[n]/steps_per_mm;
+          mpos -= offset[idx];
+          printFloat_CoordValue(mpos);
+        }
+      }
+    }
+    t[pass] = (seconds()-start)*1e9/((double)TIMING_ROUNDS*TIMING_POSITIONS);
+  }
+  printf("test_print: timing at %g steps/mm: printCoord_Steps %.1f ns, printFloat_CoordValue %.1f ns per position\n",
+         steps_per_mm,t[0],t[1]);
+}
+
+int main()
+{
+  static const float steps_per_mm[] = {
+    250.0, 80.0, 100.0, 200.0, 320.0, 400.0, 800.0, 1600.0, 6400.0, 53.333, 157.48, 12.7, 3.0, 1.0
+  };
+  srand(1);
+  uint8_t inches;
+  for (inches=0; inches<2; inches++) {
+    settings.flags = (inches ? BITFLAG_REPORT_INCHES : 0);
+    uint8_t i;
+    for (i=0; i<sizeof(steps_per_mm)/sizeof(steps_per_mm[0]); i++) {
+      coord_steps_t coord;
+      printCoord_SetScale(&coord,steps_per_mm[i]);
+      int32_t steps;
+      // Every step position over +-1m of travel, as machine and as work position.
+      int32_t range = 1000*steps_per_mm[i];
+      for (steps=-range; steps<=range; steps++) { check(&coord,steps,steps_per_mm[i],0.0); }
+      uint32_t n;
+      for (n=0; n<200000; n++) {
+        steps = rand() % (2*range+1) - range;
+        check(&coord,steps,steps_per_mm[i],random_offset());
+      }
+      // Far positions, where float resolution reaches the last digit.
+      for (n=0; n<200000; n++) {
+        steps = (int32_t)(rand() % 2000001 - 1000000)*(rand() % 32 + 1);
+        check(&coord,steps,steps_per_mm[i],random_offset());
+      }
+    }
+  }
+  timing(80.0);
+  timing(250.0);
+  printf("test_print: %lu positions, %lu mismatches\n",(unsigned long)checked,(unsigned long)failed);
+  return(failed ? 1 : 0);
+}
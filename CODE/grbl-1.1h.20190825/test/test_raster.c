@@ -0,0 +1,147 @@
+/*
+  test_raster.c - raster payload round trip from the image encoder to the pixel runs
+  Part of Grbl host tests
+
+  A pixel pattern with every power level, single pixels, and runs longer than the repeat count,
+  the run merge limit, and the raster buffer is encoded by doc/script/raster_encode.py. Its output
+  is read through the g-code line filter, like a streamed program, once as written and once in
+  lowercase, and executed as '$LS=' and '$L=' lines. The stub stepper drains the queued pixel
+  runs, which must give back the pattern, and the planned blocks must cover the same pixels.
+*/
+
+#include "grbl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+
+#define N_PIXELS 3000
+
+system_t sys;
+settings_t settings;
+parser_state_t gc_state;
+volatile uint8_t sys_rt_exec_state;
+
+static uint8_t pattern[N_PIXELS];
+static uint8_t decoded[N_PIXELS];
+static uint16_t n_decoded;
+static uint32_t n_planned;
+static uint16_t failed;
+
+// Stands in for the step segment generator. Takes the queued runs off the raster buffer.
+static void drain()
+{
+  raster_run_t *run;
+  while ((run = raster_get_current_run()) != NULL) {
+    uint8_t i;
+    for (i=0; i<run->pixels; i++) {
+      if (n_decoded < N_PIXELS) { decoded[n_decoded] = run->power; }
+      n_decoded++;
+    }
+    raster_discard_current_run();
+  }
+}
+
+void protocol_execute_realtime() { drain(); }
+void protocol_auto_cycle_start() { }
+void protocol_exec_rt_system() { }
+void mc_line(float *target, plan_line_data_t *pl_data)
+{
+  (void)target;
+  n_planned += pl_data->raster_pixels;
+}
+
+
+static FILE *encoded;
+static uint8_t lowercase;
+
+static uint8_t encoded_read()
+{
+  int c = fgetc(encoded);
+  if (c == EOF) { return(SERIAL_NO_DATA); }
+  return(lowercase ? tolower(c) : c);
+}
+
+static const line_source_t encoded_source = { encoded_read };
+
+
+static void run(const char *test, const char *pixel_file)
+{
+  char command[256];
+  snprintf(command, sizeof(command), "python3 raster_pixels.py %s", pixel_file);
+  encoded = popen(command, "r");
+  if (encoded == NULL) { printf("test_raster: %s: no encoder\n", test); failed++; return; }
+
+  n_decoded = 0;
+  n_planned = 0;
+  raster_reset();
+  char line[LINE_BUFFER_SIZE];
+  line_reader_t reader = { LINE_MODE_GCODE, 0, 0 };
+  uint16_t lines = 0;
+  while (line_read(&encoded_source, &reader, line) == LINE_COMPLETE) {
+    if (reader.flags & LINE_FLAG_OVERFLOW) {
+      printf("test_raster: %s: line overflow\n", test);
+      failed++;
+    } else if (line[0]) {
+      uint8_t status = raster_execute_line(line);
+      if (status != STATUS_OK) { printf("test_raster: %s: status %d '%s'\n", test, status, line); failed++; }
+      lines++;
+    }
+    reader.flags = 0;
+    reader.char_counter = 0;
+  }
+  if (pclose(encoded) != 0) { printf("test_raster: %s: encoder failed\n", test); failed++; }
+  drain();
+
+  if (n_decoded != N_PIXELS) {
+    printf("test_raster: %s: %u pixels decoded, %u encoded\n", test, n_decoded, N_PIXELS);
+    failed++;
+  } else if (memcmp(decoded, pattern, N_PIXELS)) {
+    printf("test_raster: %s: decoded pixels differ\n", test);
+    failed++;
+  }
+  if (n_planned != N_PIXELS) {
+    printf("test_raster: %s: %lu pixels planned\n", test, (unsigned long)n_planned);
+    failed++;
+  }
+  printf("test_raster: %s: %u lines, %u pixels\n", test, lines, n_decoded);
+}
+
+
+int main()
+{
+  settings.steps_per_mm[X_AXIS] = 100.0;
+  gc_state.modal.units = UNITS_MODE_MM;
+
+  // Every power level, then repeats of 2, 33 and 34 pixels, then long runs and random runs.
+  uint16_t n = 0;
+  uint16_t i;
+  for (i=0; i<=RASTER_POWER_MAX; i++) { pattern[n++] = i; }
+  for (i=0; i<2; i++) { pattern[n++] = 7; }
+  for (i=0; i<33; i++) { pattern[n++] = RASTER_POWER_MAX; }
+  for (i=0; i<34; i++) { pattern[n++] = 0; }
+  for (i=0; i<300; i++) { pattern[n++] = 16; }
+  uint32_t seed = 1;
+  while (n < N_PIXELS) {
+    seed = seed*1103515245+12345;
+    uint8_t power = (seed >> 16) % (RASTER_POWER_MAX+1);
+    uint8_t length = 1+((seed >> 24) % 40);
+    while (length-- && (n < N_PIXELS)) { pattern[n++] = power; }
+  }
+
+  char pixel_file[] = "/tmp/test_raster_XXXXXX";
+  int fd = mkstemp(pixel_file);
+  FILE *f = fdopen(fd, "w");
+  for (i=0; i<N_PIXELS; i++) { fprintf(f, "%u\n", pattern[i]); }
+  fclose(f);
+
+  lowercase = false;
+  run("encoded", pixel_file);
+  lowercase = true;
+  run("lowercase", pixel_file);
+  unlink(pixel_file);
+
+  printf("test_raster: %u failures\n", failed);
+  return(failed ? 1 : 0);
+}
@@ -0,0 +1,101 @@
+/*
+  test_serial_prep.c - step segment supply while a long report waits on a full TX buffer
+  Part of Grbl host tests
+
+  A timer signal stands in for the interrupts. Each tick shifts one character out through the
+  real TX interrupt handler of serial.c, and the stepper takes a segment every SEGMENT_TICKS
+  ticks, i.e. the segment time in characters at 115200 baud. A report much longer than the TX
+  buffer is then written in a cycle. serial_write() must keep the segment buffer fed through
+  st_prep_buffer() meanwhile, so the stepper never runs dry. The control run takes the segment
+  prep out and must underrun, which shows the simulation catches a starved buffer.
+*/
+
+#include "grbl.h"
+#include <stdio.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#define SEGMENT_TICKS 115  // 10msec segment at 11520 characters per second.
+#define REPORT_LENGTH 4000 // About $$, $# and $G together.
+
+system_t sys;
+volatile uint8_t sys_rt_exec_state;
+
+void mc_reset() { }
+void system_set_exec_state_flag(uint8_t mask) { (void)mask; }
+void system_set_exec_motion_override_flag(uint8_t mask) { (void)mask; }
+void system_set_exec_accessory_override_flag(uint8_t mask) { (void)mask; }
+
+void USART_UDRE_vect(void);
+
+
+static volatile sig_atomic_t segments;   // Prepped segments waiting for the stepper.
+static volatile sig_atomic_t underruns;  // Segment periods with none left.
+static volatile sig_atomic_t ticks;
+static volatile sig_atomic_t stepping;
+static uint32_t prepped;
+static uint8_t prep_enabled;
+
+// Tops up the segment buffer like the segment generator does with a planner full of blocks.
+void st_prep_buffer()
+{
+  if (!prep_enabled) { return; }
+  sigset_t alarm, prior;
+  sigemptyset(&alarm);
+  sigaddset(&alarm,SIGALRM);
+  sigprocmask(SIG_BLOCK,&alarm,&prior); // cli()
+  while (segments < SEGMENT_BUFFER_SIZE-1) {
+    segments++;
+    prepped++;
+  }
+  sigprocmask(SIG_SETMASK,&prior,NULL);
+}
+
+static void tick(int signal)
+{
+  (void)signal;
+  if (serial_get_tx_buffer_count()) { USART_UDRE_vect(); }
+  if (stepping && (++ticks % SEGMENT_TICKS == 0)) {
+    if (segments) { segments--; } else { underruns++; }
+  }
+}
+
+static int run(uint8_t prep)
+{
+  prep_enabled = prep;
+  segments = SEGMENT_BUFFER_SIZE-1;
+  underruns = 0;
+  ticks = 0;
+  prepped = 0;
+  sys.state = STATE_CYCLE;
+  stepping = true;
+
+  uint16_t i;
+  for (i=0; i<REPORT_LENGTH; i++) { serial_write('A'+(i % 26)); }
+  while (serial_get_tx_buffer_count()) { st_prep_buffer(); } // The main loop preps as well.
+  stepping = false;
+  return(underruns);
+}
+
+int main()
+{
+  signal(SIGALRM,tick);
+  struct itimerval period = { { 0, 20 }, { 0, 20 } };
+  setitimer(ITIMER_REAL,&period,NULL);
+
+  int failed = 0;
+  int control = run(false);
+  if (control == 0) {
+    printf("test_serial_prep: control run without segment prep did not underrun\n");
+    failed = 1;
+  }
+  int result = run(true);
+  if (result != 0) {
+    printf("test_serial_prep: %d segment underruns while the report waited on TX\n",result);
+    failed = 1;
+  }
+  printf("test_serial_prep: %d bytes over %d segments, %lu segments prepped in the TX wait, "
+         "%d underruns (%d without prep)\n",REPORT_LENGTH,REPORT_LENGTH/SEGMENT_TICKS,
+         (unsigned long)prepped,result,control);
+  return(failed);
+}
@@ -0,0 +1,100 @@
+/*
+  test_spinup.c - feed motion tracking of the spindle spin-up overlap
+  Part of Grbl host tests
+
+  A rapid, a feed motion and another rapid are planned and executed by the segment generator and
+  the stepper ISR, called in turn like the main loop and the timer do. The feed motion moves Y
+  only and the rapids X only, so the Y position tells, whether the feed motion is complete. The
+  spindle may change, once plan_check_rapid_buffer() and st_check_rapid_segments() both hold. That
+  must not happen before the last feed step, and must happen before the rapid after it takes its
+  first step.
+*/
+
+#include "grbl.h"
+#include <stdio.h>
+
+system_t sys;
+settings_t settings;
+int32_t sys_position[N_AXIS];
+volatile uint8_t sys_probe_state;
+volatile uint8_t sys_rt_exec_state;
+volatile uint8_t sys_rt_exec_alarm;
+
+void system_set_exec_state_flag(uint8_t mask) { sys_rt_exec_state |= mask; }
+void protocol_execute_realtime() { }
+void protocol_exec_rt_system() { }
+void probe_state_monitor() { }
+void spindle_set_speed(uint8_t pwm_value) { (void)pwm_value; }
+uint8_t spindle_compute_pwm_value(float rpm) { (void)rpm; return(0); }
+uint8_t get_step_pin_mask(uint8_t i) { return(1<<(X_STEP_BIT+i)); }
+uint8_t get_direction_pin_mask(uint8_t i) { return(1<<(X_DIRECTION_BIT+i)); }
+void TIMER1_COMPA_vect(void);
+
+#define STEPS_PER_MM 100.0
+
+static uint16_t failed;
+
+static void line(float x, float y, uint8_t rapid)
+{
+  float target[N_AXIS] = { x, y, 0.0 };
+  plan_line_data_t pl_data = { 600.0, 0.0, (rapid ? PL_COND_FLAG_RAPID_MOTION : 0) };
+  if (plan_buffer_line(target,&pl_data) == PLAN_EMPTY_BLOCK) {
+    printf("test_spinup: empty block\n");
+    failed++;
+  }
+}
+
+static uint8_t spindle_may_change()
+{
+  return(plan_check_rapid_buffer() && st_check_rapid_segments());
+}
+
+int main()
+{
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    settings.steps_per_mm[idx] = STEPS_PER_MM;
+    settings.max_rate[idx] = 3000.0;
+    settings.acceleration[idx] = 50.0*60*60;
+  }
+  settings.junction_deviation = 0.01;
+  settings.stepper_idle_lock_time = 255;
+  sys.f_override = sys.r_override = DEFAULT_FEED_OVERRIDE;
+  sys.spindle_speed_ovr = DEFAULT_SPINDLE_SPEED_OVERRIDE;
+  plan_reset();
+  st_reset();
+
+  if (!spindle_may_change()) { printf("test_spinup: empty buffers hold the spindle\n"); failed++; }
+  line(10.0, 0.0, true);
+  line(10.0, 5.0, false);
+  line(20.0, 5.0, true);
+  if (spindle_may_change()) { printf("test_spinup: queued feed motion not seen\n"); failed++; }
+
+  const int32_t feed_start = 10.0*STEPS_PER_MM;
+  const int32_t feed_end = 5.0*STEPS_PER_MM;
+  const int32_t rapid_end = 20.0*STEPS_PER_MM;
+  int32_t changed_at = -1;
+  uint32_t ticks = 0;
+  sys.state = STATE_CYCLE;
+  while (!(sys_rt_exec_state & EXEC_CYCLE_STOP) && (ticks++ < 1000000)) {
+    st_prep_buffer();
+    TIMER1_COMPA_vect();
+    if (spindle_may_change() && (changed_at < 0)) {
+      if (sys_position[Y_AXIS] != feed_end) {
+        printf("test_spinup: spindle may change at Y %ld of %ld steps\n",(long)sys_position[Y_AXIS],(long)feed_end);
+        failed++;
+        break;
+      }
+      changed_at = sys_position[X_AXIS];
+    }
+  }
+  if (sys_position[X_AXIS] != rapid_end) { printf("test_spinup: motions not completed\n"); failed++; }
+  if (changed_at != feed_start) {
+    printf("test_spinup: spindle not changed at the start of the rapid\n");
+    failed++;
+  }
+
+  printf("test_spinup: %lu ticks, spindle may change at X %ld of %ld steps, %u failures\n",
+         (unsigned long)ticks,(long)changed_at,(long)rapid_end,failed);
+  return(failed ? 1 : 0);
+}
@@ -0,0 +1,88 @@
+/*
+  test_truncate.c - planner state after a velocity jog truncates the block buffer
+  Part of Grbl host tests
+
+  Built with COREXY, where block steps are A and B motor steps. Four lines are planned and the
+  buffer is truncated back to the first two. The planner position must be back at the end of the
+  second line, and the junction speed towards the next line must be the same as if the last two
+  lines had never been planned.
+*/
+
+#include "grbl.h"
+#include <stdio.h>
+
+system_t sys;
+settings_t settings;
+int32_t sys_position[N_AXIS];
+
+uint8_t get_direction_pin_mask(uint8_t i) { return(1<<(X_DIRECTION_BIT+i)); }
+void st_update_plan_block_parameters() { }
+float st_get_realtime_rate() { return(0.0); }
+void protocol_execute_realtime() { }
+void protocol_exec_rt_system() { }
+int32_t system_convert_corexy_to_x_axis_steps(int32_t *steps) { return((steps[A_MOTOR]+steps[B_MOTOR])/2); }
+int32_t system_convert_corexy_to_y_axis_steps(int32_t *steps) { return((steps[A_MOTOR]-steps[B_MOTOR])/2); }
+
+static uint16_t failed;
+
+static void line(float x, float y)
+{
+  float target[N_AXIS] = { x, y, 0.0 };
+  plan_line_data_t pl_data = { 600.0, 0.0, 0 };
+  if (plan_buffer_line(target,&pl_data) == PLAN_EMPTY_BLOCK) {
+    printf("test_truncate: empty block\n");
+    failed++;
+  }
+}
+
+// Junction speed from the planner position towards (x,y), with the unit vector in motor space
+// like plan_buffer_line() computes it.
+static float junction_speed_sqr(float x, float y)
+{
+  float position[N_AXIS];
+  plan_get_planner_mpos(position);
+  float dx = x-position[X_AXIS];
+  float dy = y-position[Y_AXIS];
+  float unit_vec[N_AXIS] = { dx+dy, dx-dy, 0.0 };
+  convert_delta_vector_to_unit_vector(unit_vec);
+  return(plan_compute_junction_speed_sqr(unit_vec));
+}
+
+int main()
+{
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    settings.steps_per_mm[idx] = 100.0;
+    settings.max_rate[idx] = 3000.0;
+    settings.acceleration[idx] = 50.0*60*60;
+  }
+  settings.junction_deviation = 0.01;
+  sys.f_override = sys.r_override = DEFAULT_FEED_OVERRIDE;
+  plan_reset();
+
+  line(10.0, 0.0);
+  line(13.0, 4.0); // Not along a motor direction, so X/Y and A/B unit vectors differ.
+  float expected = junction_speed_sqr(3.0, 10.0);
+  line(3.0, 10.0);
+  line(-5.0, 12.0);
+
+  plan_truncate_buffer(16.0); // Block lengths are in motor space, 14.1mm and 7.1mm for the first two.
+  if (plan_get_block_buffer_count() != 2) {
+    printf("test_truncate: %u blocks kept\n",plan_get_block_buffer_count());
+    failed++;
+  }
+  float position[N_AXIS];
+  plan_get_planner_mpos(position);
+  if ((position[X_AXIS] != 13.0) || (position[Y_AXIS] != 4.0)) {
+    printf("test_truncate: planner position %.3f,%.3f\n",position[X_AXIS],position[Y_AXIS]);
+    failed++;
+  }
+  float junction = junction_speed_sqr(3.0, 10.0);
+  if (junction != expected) {
+    printf("test_truncate: junction speed sqr %.3f, expected %.3f\n",junction,expected);
+    failed++;
+  }
+
+  printf("test_truncate: junction speed sqr %.3f, %u failures\n",junction,failed);
+  return(failed ? 1 : 0);
+}
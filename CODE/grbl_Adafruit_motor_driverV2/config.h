@@ -13,6 +13,14 @@
     #define BAUD_RATE 115200
     #define SPINDLE_PORT 1    //on adafruit motor shield
     
+    /*
+     * I2C clock for the motor shields. The PCA9685 goes up to 1000000 
+     * (Fast-mode Plus), which cuts the bus time of a step by more than half, 
+     * but the rise time at 1MHz needs stronger pull-ups than the internal 
+     * ones. Stay at 400000 if steps get lost.
+     */
+    #define SHIELD_I2C_CLOCK 400000L
+    
     
     //limit swtch pins
     #define X_LIMIT_START_PIN 2
@@ -38,17 +46,55 @@
     */
     #define N_ARC_CORRECTION 25 // Integer (1-255)
 
+    /*
+     * Number of linear moves buffered between the gcode parser and the step 
+     * interrupt. While the buffer has room the parser keeps reading lines as 
+     * the motors move, so consecutive lines and arc segments run without a 
+     * pause. The planner also looks ahead over these blocks to keep the speed 
+     * up through the junctions. Each block takes about 64 bytes of RAM.
+     */
+    #define BLOCK_BUFFER_SIZE 8
+
+    /*
+     * The step interrupt never runs slower than this, so a block that starts 
+     * or ends at a standstill does not wait forever on its first step
+     */
+    #define MINIMUM_STEPS_PER_MINUTE 800
+
+
+    /*
+     * Uncomment to drive the steppers in MICROSTEP style instead of DOUBLE 
+     * full steps. The coil currents then follow a 12 bit sine, which runs 
+     * much smoother and quieter at mid speeds. A full step becomes 
+     * STEP_MICROSTEPS step events, so the default steps per turn below scale 
+     * with it (reset the settings after switching), and the top feed rate 
+     * drops by the same factor because each step event is an I2C write. 
+     * STEP_MICROSTEPS must match MICROSTEPS in Adafruit_MotorShield.h
+     */
+    //#define MICROSTEPPING
+    #ifdef MICROSTEPPING
+        #define STEPPING_STYLE MICROSTEP
+        #define STEP_MICROSTEPS 16
+    #else
+        #define STEPPING_STYLE DOUBLE
+        #define STEP_MICROSTEPS 1
+    #endif
+
 
     //Default settings (used when resetting eeprom-settings)
     #define DEFAULT_ROD_STEP 1.25  // mm per turn
-    #define DEFAULT_X_STEPS_PER_TURN 48
-    #define DEFAULT_Y_STEPS_PER_TURN 48
-    #define DEFAULT_Z_STEPS_PER_TURN 48
+    #define DEFAULT_X_STEPS_PER_TURN (48 * STEP_MICROSTEPS)
+    #define DEFAULT_Y_STEPS_PER_TURN (48 * STEP_MICROSTEPS)
+    #define DEFAULT_Z_STEPS_PER_TURN (48 * STEP_MICROSTEPS)
 
     #define DEFAULT_MM_PER_ARC_SEGMENT 0.1
     #define DEFAULT_RAPID_FEEDRATE 500.0 // mm/min
     #define DEFAULT_FEEDRATE 500.0
     #define DEFAULT_STEPPING_INVERT_MASK 1
+    #define DEFAULT_X_ACCELERATION 50.0 // mm/sec^2
+    #define DEFAULT_Y_ACCELERATION 50.0 // mm/sec^2
+    #define DEFAULT_Z_ACCELERATION 25.0 // mm/sec^2
+    #define DEFAULT_JUNCTION_DEVIATION 0.05 // mm
     #define DEFAULT_SPINDLE_SPEED 255;
     
     /**
@@ -64,6 +110,17 @@
      */
     #define RELEASE_AFTER_MOVE 1;
 
+    /*
+     * With release after move off the coils stay at full current while the 
+     * machine stands still. After DEFAULT_IDLE_HOLD_DELAY seconds without a 
+     * step the coil PWM drops to DEFAULT_IDLE_HOLD_CURRENT percent, enough to 
+     * hold the position without cooking the drivers. The next step of a motor 
+     * brings it back to full current. 100 disables it
+     * Both can be changed from settings
+     */
+    #define DEFAULT_IDLE_HOLD_DELAY 1.0 // sec
+    #define DEFAULT_IDLE_HOLD_CURRENT 30.0 // % of full coil PWM
+
 
 #endif
 
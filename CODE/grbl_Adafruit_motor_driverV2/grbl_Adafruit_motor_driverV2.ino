@@ -21,7 +21,6 @@
  */
 
 
-#include <Wire.h>
 #include <Adafruit_MotorShield.h>
 #include "utility/Adafruit_MS_PWMServoDriver.h"
 
@@ -31,10 +30,12 @@
 
 #include "config.h"
 #include "stepper_control.h"
+#include "planner.h"
 #include "gcode.h"
 #include "protocol.h"
 #include "settings.h"
 #include "serial.h"
+#include "limit_switch.h"
 
 
 void setup(void)
@@ -45,6 +46,8 @@ void setup(void)
   protocol_init();
   settings_init(); 
   gc_init();
+  plan_init();
+  ls_init();
   motors_init();
  
 
@@ -54,4 +57,6 @@ void setup(void)
 void loop() {
     //process the serial protocol
     protocol_process(); 
+    //reduce the holding current of idle motors
+    st_idle_hold();
 }
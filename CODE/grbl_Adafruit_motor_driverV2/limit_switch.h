@@ -38,6 +38,13 @@
 #define Y_motor 1
 #define Z_motor 2
 
+//Bit set while the switch is closed, bit (motor * 2) for the start and bit (motor * 2 + 1) for the end switch
+//Kept up to date by the pin change interrupt
+extern volatile uint8_t ls_state;
+
+//Read the switches and enable their pin change interrupts if settings.limit_switch is 1
+void ls_init();
+
 //check for enabled limit swith
 int ls_check(int motor, int dir);
 
@@ -22,39 +22,93 @@
 
 #include "config.h"
 #include <Arduino.h>
+#include <avr/interrupt.h>
+#include "settings.h"
 #include "limit_switch.h"
 
+#define LS_COUNT 6
+
+volatile uint8_t ls_state;
+
+//Same order as the bits of ls_state
+static const uint8_t ls_pin[LS_COUNT] = {
+    X_LIMIT_START_PIN, X_LIMIT_END_PIN,
+    Y_LIMIT_START_PIN, Y_LIMIT_END_PIN,
+    Z_LIMIT_START_PIN, Z_LIMIT_END_PIN
+};
+static const uint8_t ls_status[LS_COUNT] = {
+    X_LIMIT_START_ENABLE, X_LIMIT_END_ENABLE,
+    Y_LIMIT_START_ENABLE, Y_LIMIT_END_ENABLE,
+    Z_LIMIT_START_ENABLE, Z_LIMIT_END_ENABLE
+};
+//Input register and bit of each pin, looked up once so the interrupt reads the ports directly
+static volatile uint8_t *ls_port[LS_COUNT];
+static uint8_t ls_bit[LS_COUNT];
+
+/**
+ * Sample all switches into ls_state
+ */
+static void ls_update() {
+    uint8_t state = 0;
+    for (uint8_t i = 0; i < LS_COUNT; i++) {
+        if (*ls_port[i] & ls_bit[i]) {
+            state |= 1 << i;
+        }
+    }
+    ls_state = state;
+}
+
+/**
+ * Set up the limit switch pins and enable the pin change interrupt on each
+ * while settings.limit_switch is 1. Without switches the pins float and
+ * every edge of the noise would run the interrupt, so it is disabled then
+ * Called again whenever $12 changes
+ * The default pins 2 to 7 are all on PCINT2
+ */
+void ls_init() {
+    bool enabled = (settings.limit_switch == 1);
+    for (uint8_t i = 0; i < LS_COUNT; i++) {
+        pinMode(ls_pin[i], INPUT);
+        ls_port[i] = portInputRegister(digitalPinToPort(ls_pin[i]));
+        ls_bit[i] = digitalPinToBitMask(ls_pin[i]);
+        if (digitalPinToPCICR(ls_pin[i])) {
+            if (enabled) {
+                *digitalPinToPCMSK(ls_pin[i]) |= (1 << digitalPinToPCMSKbit(ls_pin[i]));
+                *digitalPinToPCICR(ls_pin[i]) |= (1 << digitalPinToPCICRbit(ls_pin[i]));
+            } else {
+                *digitalPinToPCMSK(ls_pin[i]) &= ~(1 << digitalPinToPCMSKbit(ls_pin[i]));
+                *digitalPinToPCICR(ls_pin[i]) &= ~(1 << digitalPinToPCICRbit(ls_pin[i]));
+            }
+        }
+    }
+    if (enabled) {
+        ls_update();
+    } else {
+        ls_state = 0;
+    }
+}
+
+/**
+ * Any edge on a switch pin, whichever port group it is on
+ */
+ISR(PCINT0_vect) {
+    ls_update();
+}
+ISR(PCINT1_vect, ISR_ALIASOF(PCINT0_vect));
+ISR(PCINT2_vect, ISR_ALIASOF(PCINT0_vect));
+
 /**
  * Check the limit switch according to axis and direction
+ * Only tests the state cached by the pin change interrupt, it runs before every step
  * 
  * @param int motor -- axis
  * @param int direction
  * @return int status
  */
 int ls_check(int motor, int direction) {
-    if (motor == X_motor) {
-        if (digitalRead(X_LIMIT_END_PIN) && direction > 0) {
-            return X_LIMIT_END_ENABLE;
-        }
-        if (digitalRead(X_LIMIT_START_PIN) && direction < 0) {
-            return X_LIMIT_START_ENABLE;
-        }
-    }
-    if (motor == Y_motor) {
-        if (digitalRead(Y_LIMIT_END_PIN) && direction > 0) {
-            return Y_LIMIT_END_ENABLE;
-        }
-        if (digitalRead(Y_LIMIT_START_PIN) && direction < 0) {
-            return Y_LIMIT_START_ENABLE;
-        }
-    }
-    if (motor == Z_motor) {
-        if (digitalRead(Z_LIMIT_END_PIN) && direction > 0) {
-            return Z_LIMIT_END_ENABLE;
-        }
-        if (digitalRead(Z_LIMIT_START_PIN) && direction < 0) {
-            return Z_LIMIT_START_ENABLE;
-        }
+    uint8_t i = (motor << 1) | (direction > 0);
+    if (ls_state & (1 << i)) {
+        return ls_status[i];
     }
     return NO_SWTCH_ENABLE;
 }
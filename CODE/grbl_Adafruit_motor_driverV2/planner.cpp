@@ -0,0 +1,396 @@
+/*
+ * planner.cpp - buffers movement commands and manages the acceleration profile plan
+ */
+/**
+ * Part of Grbl interpreter modified to work with Adafruit Motor Driver V2
+ *
+ * The block buffer sits between gcode.cpp and the step interrupt in
+ * stepper_control.cpp so the parser can keep reading lines while the
+ * motors are moving.
+ *
+ *
+ * Original license:***********************************************************
+ * Copyright (c) 2009-2011 Simen Svale Skogsrud
+ * Copyright (c) 2011 Sungeun K. Jeon
+ *
+ * Grbl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Grbl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <math.h>
+#include <Arduino.h>
+
+#include "config.h"
+#include "nuts_bolts.h"
+#include "settings.h"
+#include "planner.h"
+#include "stepper_control.h"
+
+//A ring buffer for motion instructions
+static block_t block_buffer[BLOCK_BUFFER_SIZE];
+//Index of the next block to be pushed
+static volatile uint8_t block_buffer_head;
+//Index of the block to process now
+static volatile uint8_t block_buffer_tail;
+//Set while planner_recalculate() rewrites the queued blocks
+static volatile uint8_t planner_locked;
+
+//Unit vector and nominal speed of the previous path line segment, used for the junction speed
+static double previous_unit_vec[3];
+static double previous_nominal_speed;
+
+/**
+ * Returns the index of the next block in the ring buffer
+ *
+ * @param uint8_t block_index
+ * @return uint8_t
+ */
+static uint8_t next_block_index(uint8_t block_index) {
+    block_index++;
+    if (block_index == BLOCK_BUFFER_SIZE) {
+        block_index = 0;
+    }
+    return block_index;
+}
+
+/**
+ * Returns the index of the previous block in the ring buffer
+ *
+ * @param uint8_t block_index
+ * @return uint8_t
+ */
+static uint8_t prev_block_index(uint8_t block_index) {
+    if (block_index == 0) {
+        block_index = BLOCK_BUFFER_SIZE;
+    }
+    block_index--;
+    return block_index;
+}
+
+/**
+ * Calculates the distance (not time) it takes to accelerate from initial_rate to target_rate
+ * using the given acceleration
+ *
+ * @param double initial_rate
+ * @param double target_rate
+ * @param double acceleration
+ * @return double
+ */
+static double estimate_acceleration_distance(double initial_rate, double target_rate, double acceleration) {
+    return ((target_rate * target_rate - initial_rate * initial_rate) / (2 * acceleration));
+}
+
+/**
+ * This function gives you the point at which you must start braking (at the rate of -acceleration) if
+ * you started at speed initial_rate and accelerated until this point and want to end at the final_rate after
+ * a total travel of distance. This can be used to compute the intersection point between acceleration and
+ * deceleration in the cases where the trapezoid has no plateau (i.e. never reaches maximum speed)
+ *
+ * @param double initial_rate
+ * @param double final_rate
+ * @param double acceleration
+ * @param double distance
+ * @return double
+ */
+static double intersection_distance(double initial_rate, double final_rate, double acceleration, double distance) {
+    return ((2 * acceleration * distance - initial_rate * initial_rate + final_rate * final_rate) / (4 * acceleration));
+}
+
+/**
+ * Calculates the maximum allowable speed at this point when you must be able to reach target_velocity
+ * using the acceleration within the allotted distance
+ *
+ * @param double acceleration   negative
+ * @param double target_velocity
+ * @param double distance
+ * @return double
+ */
+static double max_allowable_speed(double acceleration, double target_velocity, double distance) {
+    return (sqrt(target_velocity * target_velocity - 2 * acceleration * distance));
+}
+
+/**
+ * Calculates trapezoid parameters so that the entry and exit speeds are respected
+ * The factors are the fraction of the nominal speed
+ *
+ * @param block_t* block
+ * @param double entry_factor
+ * @param double exit_factor
+ */
+static void calculate_trapezoid_for_block(block_t *block, double entry_factor, double exit_factor) {
+    block->initial_rate = block->nominal_rate * entry_factor;
+    block->final_rate = block->nominal_rate * exit_factor;
+    double acceleration = block->rate_acceleration;
+
+    long accelerate_steps = ceil(estimate_acceleration_distance(block->initial_rate, block->nominal_rate, acceleration));
+    long decelerate_steps = floor(estimate_acceleration_distance(block->nominal_rate, block->final_rate, -acceleration));
+
+    //Calculate the size of Plateau of Nominal Rate
+    long plateau_steps = block->step_event_count - accelerate_steps - decelerate_steps;
+
+    //Is the Plateau of Nominal Rate smaller than nothing? That means no cruising, and we will
+    //have to use intersection_distance() to calculate when to abort acceleration and start braking
+    //in order to reach the final_rate exactly at the end of this block
+    if (plateau_steps < 0) {
+        accelerate_steps = ceil(intersection_distance(block->initial_rate, block->final_rate,
+            acceleration, block->step_event_count));
+        //Check limits due to numerical round-off
+        accelerate_steps = max(accelerate_steps, 0);
+        accelerate_steps = min((uint32_t) accelerate_steps, block->step_event_count);
+        plateau_steps = 0;
+    }
+
+    block->accelerate_until = accelerate_steps;
+    block->decelerate_after = accelerate_steps + plateau_steps;
+}
+
+/**
+ * Recalculates the motion plan according to the following algorithm:
+ *
+ *   1. Go over every block in reverse order and calculate a junction speed reduction (i.e. block_t.entry_speed)
+ *      so that:
+ *     a. The junction speed is equal to or less than the maximum junction speed limit
+ *     b. No speed reduction within one block requires faster deceleration than the one, true constant
+ *        acceleration.
+ *   2. Go over every block in chronological order and dial down junction speed values if
+ *     a. The speed increase within one block would require faster acceleration than the one, true
+ *        constant acceleration.
+ *   3. Recalculate the trapezoids of all blocks whose entry or exit speed changed
+ *
+ * The block the step interrupt is tracing is never touched and neither is the entry speed of the block
+ * after it, that speed is already the exit speed the interrupt is slowing down to.
+ * The first block of an idle buffer always starts from a standstill.
+ */
+static void planner_recalculate() {
+    uint8_t first = block_buffer_tail;
+    if (block_buffer[first].busy) {
+        first = next_block_index(first);
+    }
+    uint8_t last = prev_block_index(block_buffer_head);
+    if (first == block_buffer_head) {
+        return;
+    }
+
+    block_t *current;
+    block_t *next = NULL;
+    uint8_t block_index;
+
+    //Reverse pass
+    for (block_index = last; block_index != first; block_index = prev_block_index(block_index)) {
+        current = &block_buffer[block_index];
+        double exit_speed = (next == NULL) ? 0.0 : next->entry_speed;
+        if (current->entry_speed != current->max_entry_speed) {
+            //If nominal length true, max junction speed is guaranteed to be reached. Only compute
+            //for max allowable speed if block is decelerating and nominal length is false
+            if ((!current->nominal_length_flag) && (current->max_entry_speed > exit_speed)) {
+                current->entry_speed = min(current->max_entry_speed,
+                    max_allowable_speed(-current->acceleration, exit_speed, current->millimeters));
+            } else {
+                current->entry_speed = current->max_entry_speed;
+            }
+            current->recalculate_flag = true;
+        }
+        next = current;
+    }
+
+    //Forward pass
+    block_t *previous = &block_buffer[first];
+    for (block_index = next_block_index(first); block_index != block_buffer_head; block_index = next_block_index(block_index)) {
+        current = &block_buffer[block_index];
+        //If the previous block is an acceleration block, but it is not long enough to complete the
+        //full speed change within the block, we need to adjust the entry speed accordingly
+        if (!previous->nominal_length_flag && previous->entry_speed < current->entry_speed) {
+            double entry_speed = min(current->entry_speed,
+                max_allowable_speed(-previous->acceleration, previous->entry_speed, previous->millimeters));
+            if (current->entry_speed != entry_speed) {
+                current->entry_speed = entry_speed;
+                current->recalculate_flag = true;
+            }
+        }
+        previous = current;
+    }
+
+    //Recalculate the trapezoids, the last block always ends in a standstill
+    for (block_index = first; block_index != block_buffer_head; block_index = next_block_index(block_index)) {
+        current = &block_buffer[block_index];
+        next = (block_index == last) ? NULL : &block_buffer[next_block_index(block_index)];
+        if (current->recalculate_flag || next == NULL || next->recalculate_flag) {
+            double exit_speed = (next == NULL) ? 0.0 : next->entry_speed;
+            calculate_trapezoid_for_block(current, current->entry_speed / current->nominal_speed,
+                exit_speed / current->nominal_speed);
+            current->recalculate_flag = false;
+        }
+    }
+}
+
+/**
+ * Empty the block buffer
+ */
+void plan_init() {
+    block_buffer_head = 0;
+    block_buffer_tail = 0;
+    planner_locked = false;
+    clear_vector_double(previous_unit_vec);
+    previous_nominal_speed = 0.0;
+}
+
+/**
+ * Discard the block the stepper interrupt just finished
+ */
+void plan_discard_current_block() {
+    if (block_buffer_head != block_buffer_tail) {
+        block_buffer_tail = next_block_index(block_buffer_tail);
+    }
+}
+
+/**
+ * Return the block at the tail of the buffer or NULL if the buffer is empty
+ *
+ * @return block_t*
+ */
+block_t *plan_get_current_block() {
+    if (block_buffer_head == block_buffer_tail) {
+        return NULL;
+    }
+    return &block_buffer[block_buffer_tail];
+}
+
+/**
+ * True while the queued blocks are being replanned
+ *
+ * @return uint8_t
+ */
+uint8_t plan_is_locked() {
+    return planner_locked;
+}
+
+/**
+ * Add a new linear movement to the buffer
+ * Works out the nominal speed, the acceleration along the path from the per axis
+ * limits and the junction speed with the previous line, then replans the buffer
+ * Waits for the stepper interrupt to free a slot if the buffer is full
+ *
+ * @param long[3] steps       signed number of steps on each axis
+ * @param double  feed_rate   mm/min or, when invert_feed_rate is set, 1/minutes
+ * @param uint8_t invert_feed_rate
+ */
+void plan_buffer_line(long *steps, double feed_rate, uint8_t invert_feed_rate) {
+    //Calculate the buffer head after we push this block
+    uint8_t next_buffer_head = next_block_index(block_buffer_head);
+    //If the buffer is full: good! That means we are well ahead of the robot.
+    //Rest here until there is room in the buffer.
+    while (block_buffer_tail == next_buffer_head) {
+    }
+
+    block_t *block = &block_buffer[block_buffer_head];
+    block->direction_bits = 0;
+    block->step_event_count = 0;
+    for (uint8_t i = 0; i < 3; i++) {
+        block->steps[i] = labs(steps[i]);
+        if (steps[i] < 0) {
+            block->direction_bits |= (1 << i);
+        }
+        if (block->step_event_count < block->steps[i]) {
+            block->step_event_count = block->steps[i];
+        }
+    }
+    //Bail if this is a zero-length block
+    if (block->step_event_count == 0) {
+        return;
+    }
+    block->busy = false;
+    //Keep the step interrupt from starting a new block until the plan is consistent again
+    planner_locked = true;
+
+    double delta_mm[3];
+    for (uint8_t i = 0; i < 3; i++) {
+        delta_mm[i] = steps[i] / settings.steps_per_mm[i];
+    }
+    block->millimeters = sqrt(delta_mm[X_AXIS] * delta_mm[X_AXIS] +
+        delta_mm[Y_AXIS] * delta_mm[Y_AXIS] + delta_mm[Z_AXIS] * delta_mm[Z_AXIS]);
+    double inverse_millimeters = 1.0 / block->millimeters;
+
+    //Calculate speed in mm/minute for each axis. No divide by zero due to previous checks
+    double inverse_minute;
+    if (invert_feed_rate) {
+        inverse_minute = feed_rate;
+    } else {
+        inverse_minute = feed_rate * inverse_millimeters;
+    }
+    block->nominal_speed = block->millimeters * inverse_minute;
+    block->nominal_rate = block->step_event_count * inverse_minute;
+
+    //The acceleration along the path is limited by the axis that has the least headroom
+    //settings.acceleration is mm/sec^2, the planner works in mm/min^2
+    double unit_vec[3];
+    block->acceleration = 0.0;
+    for (uint8_t i = 0; i < 3; i++) {
+        unit_vec[i] = delta_mm[i] * inverse_millimeters;
+        if (block->steps[i] != 0) {
+            double axis_acceleration = settings.acceleration[i] * 60 * 60 / fabs(unit_vec[i]);
+            if (block->acceleration == 0.0 || axis_acceleration < block->acceleration) {
+                block->acceleration = axis_acceleration;
+            }
+        }
+    }
+    block->rate_acceleration = block->acceleration * block->step_event_count * inverse_millimeters;
+
+    //Compute the maximum allowable entry speed at the junction by centripetal acceleration approximation.
+    //Let a circle be tangent to both previous and current path line segments, where the junction
+    //deviation is defined as the distance from the junction to the closest edge of the circle,
+    //colinear with the circle center. The circular segment joining the two paths represents the
+    //path of centripetal acceleration. Solve for max velocity based on max acceleration about the
+    //radius of the circle, defined indirectly by junction deviation.
+    //Start from a standstill if the buffer is empty or the previous block is already being traced,
+    //the interrupt is slowing it down to a stop.
+    double vmax_junction = 0.0;
+    if ((block_buffer_head != block_buffer_tail) && (previous_nominal_speed > 0.0)
+            && !block_buffer[prev_block_index(block_buffer_head)].busy) {
+        //Compute cosine of angle between previous and current path. (prev_unit_vec is negative)
+        double cos_theta = - previous_unit_vec[X_AXIS] * unit_vec[X_AXIS]
+                           - previous_unit_vec[Y_AXIS] * unit_vec[Y_AXIS]
+                           - previous_unit_vec[Z_AXIS] * unit_vec[Z_AXIS];
+
+        //Skip and use default max junction speed for 0 degree acute junction
+        if (cos_theta < 0.95) {
+            vmax_junction = min(previous_nominal_speed, block->nominal_speed);
+            //Skip and avoid divide by zero for straight junctions at 180 degrees. Limit to min() of nominal speeds
+            if (cos_theta > -0.95) {
+                //Compute maximum junction velocity based on maximum acceleration and junction deviation
+                double sin_theta_d2 = sqrt(0.5 * (1.0 - cos_theta)); // Trig half angle identity. Always positive
+                vmax_junction = min(vmax_junction,
+                    sqrt(block->acceleration * settings.junction_deviation * sin_theta_d2 / (1.0 - sin_theta_d2)));
+            }
+        }
+    }
+    block->max_entry_speed = vmax_junction;
+
+    //Initialize block entry speed. Compute based on deceleration to a stop
+    double v_allowable = max_allowable_speed(-block->acceleration, 0.0, block->millimeters);
+    block->entry_speed = min(vmax_junction, v_allowable);
+
+    //If the nominal speed can be reached from a standstill within the block, the junction speeds of
+    //this block never need to be checked against the acceleration in the passes above
+    block->nominal_length_flag = (block->nominal_speed <= v_allowable);
+    block->recalculate_flag = true;
+
+    //Update previous path unit_vector and nominal speed
+    memcpy(previous_unit_vec, unit_vec, sizeof (unit_vec));
+    previous_nominal_speed = block->nominal_speed;
+
+    //Move buffer head and replan
+    block_buffer_head = next_buffer_head;
+    planner_recalculate();
+    planner_locked = false;
+
+    st_wake_up();
+}
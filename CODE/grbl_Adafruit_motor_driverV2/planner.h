@@ -0,0 +1,87 @@
+/*
+ * planner.h - buffers movement commands and manages the acceleration profile plan
+ */
+/**
+ * Part of Grbl interpreter modified to work with Adafruit Motor Driver V2
+ *
+ *
+ *
+ * Original license:***********************************************************
+ * Copyright (c) 2009-2011 Simen Svale Skogsrud
+ * Copyright (c) 2011 Sungeun K. Jeon
+ *
+ * Grbl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Grbl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef planner_h
+#define planner_h
+
+#include <inttypes.h>
+
+//This struct is used when buffering the setup for each linear movement
+//"nominal" values are as specified in the source g-code and may never actually be reached
+typedef struct {
+    //Fields used by the bresenham algorithm for tracing the line
+    //Step count along each axis
+    uint32_t steps[3];
+    //The direction bit set for this block, bit n set means axis n moves backward
+    uint8_t direction_bits;
+    //The number of step events required to complete this block
+    uint32_t step_event_count;
+
+    //Fields used by the motion planner to manage acceleration
+    //The nominal speed for this block in mm/min
+    double nominal_speed;
+    //Entry speed at previous-current junction in mm/min
+    double entry_speed;
+    //Maximum allowable junction entry speed in mm/min
+    double max_entry_speed;
+    //The total travel of this block in mm
+    double millimeters;
+    //Acceleration along the path of this block in mm/min^2
+    double acceleration;
+    //Planner flag to recalculate trapezoids on entry junction
+    uint8_t recalculate_flag;
+    //Planner flag for nominal speed always reached
+    uint8_t nominal_length_flag;
+    //Set by the step interrupt when it starts tracing the block, the planner leaves it alone from then on
+    volatile uint8_t busy;
+
+    //Settings for the trapezoid generator, in steps/min and steps/min^2
+    double initial_rate;
+    double nominal_rate;
+    double final_rate;
+    double rate_acceleration;
+    //The index of the step event on which to stop acceleration
+    uint32_t accelerate_until;
+    //The index of the step event on which to start decelerating
+    uint32_t decelerate_after;
+} block_t;
+
+//Initialize the motion plan subsystem
+void plan_init();
+
+//Add a new linear movement to the buffer. steps[] is the signed step count on each axis.
+//Blocks while the buffer is full
+void plan_buffer_line(long *steps, double feed_rate, uint8_t invert_feed_rate);
+
+//Called when the current block is no longer needed. Discards the block and makes the memory
+//available for new blocks. Only called from the stepper interrupt
+void plan_discard_current_block();
+
+//Gets the current block. Returns NULL if buffer empty
+block_t *plan_get_current_block();
+
+//True while the planner is rewriting the trapezoids of the queued blocks
+//The step interrupt must not start a new block meanwhile
+uint8_t plan_is_locked();
+
+#endif
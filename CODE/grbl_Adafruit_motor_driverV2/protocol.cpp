@@ -35,6 +35,7 @@
 #include <avr/pgmspace.h>
 #include "limit_switch.h"
 #include "g_print.h"
+#include "stepper_control.h"
 
 
 #define LINE_BUFFER_SIZE 50
@@ -46,6 +47,51 @@ static uint8_t char_counter;
 // Comment/block delete flag for processor to ignore comment characters.
 static uint8_t iscomment; 
 
+/**
+ * Print the text of an error status_code
+ * 
+ * @param int status_code
+ */
+static void status_text(int status_code) {
+    switch (status_code) {
+        case STATUS_BAD_NUMBER_FORMAT:
+            printPgmString(PSTR("Bad number format\r\n"));
+            break;
+        case STATUS_EXPECTED_COMMAND_LETTER:
+            printPgmString(PSTR("Expected command letter\r\n"));
+            break;
+        case STATUS_UNSUPPORTED_STATEMENT:
+            printPgmString(PSTR("Unsupported statement\r\n"));
+            break;
+        case STATUS_FLOATING_POINT_ERROR:
+            printPgmString(PSTR("Floating point error\r\n"));
+            break;
+        //limit swtch error
+        case X_LIMIT_END_ENABLE:
+            printPgmString(PSTR("End limit switch on X axis enabled\r\n"));
+            break;
+        case X_LIMIT_START_ENABLE:
+            printPgmString(PSTR("Start limit switch on X axis enabled\r\n"));
+            break;
+        case Y_LIMIT_END_ENABLE:
+            printPgmString(PSTR("End limit switch on Y axis enabled\r\n"));
+            break;
+        case Y_LIMIT_START_ENABLE:
+            printPgmString(PSTR("Start limit switch on Y axis enabled\r\n"));
+            break;
+        case Z_LIMIT_END_ENABLE:
+            printPgmString(PSTR("End limit switch on Z axis enabled\r\n"));
+            break;
+        case Z_LIMIT_START_ENABLE:
+            printPgmString(PSTR("Start limit switch on Z axis enabled\r\n"));
+            break;
+        default:
+            printPgmString(PSTR("Unknown error "));
+            printInteger(status_code);
+            printPgmString(PSTR("\r\n"));
+    }
+}
+
 /**
  * Process status_code and print to serial bus the error or ok
  * 
@@ -57,43 +103,20 @@ static void status_message(int status_code) {
         printPgmString(PSTR("ok\r\n"));
     } else {
         printPgmString(PSTR("error: "));
-        switch (status_code) {
-            case STATUS_BAD_NUMBER_FORMAT:
-                printPgmString(PSTR("Bad number format\r\n"));
-                break;
-            case STATUS_EXPECTED_COMMAND_LETTER:
-                printPgmString(PSTR("Expected command letter\r\n"));
-                break;
-            case STATUS_UNSUPPORTED_STATEMENT:
-                printPgmString(PSTR("Unsupported statement\r\n"));
-                break;
-            case STATUS_FLOATING_POINT_ERROR:
-                printPgmString(PSTR("Floating point error\r\n"));
-                break;
-            //limit swtch error
-            case X_LIMIT_END_ENABLE:
-                printPgmString(PSTR("End limit switch on X axis enabled\r\n"));
-                break;
-            case X_LIMIT_START_ENABLE:
-                printPgmString(PSTR("Start limit switch on X axis enabled\r\n"));
-                break;
-            case Y_LIMIT_END_ENABLE:
-                printPgmString(PSTR("End limit switch on Y axis enabled\r\n"));
-                break;
-            case Y_LIMIT_START_ENABLE:
-                printPgmString(PSTR("Start limit switch on Y axis enabled\r\n"));
-                break;
-            case Z_LIMIT_END_ENABLE:
-                printPgmString(PSTR("End limit switch on Z axis enabled\r\n"));
-                break;
-            case Z_LIMIT_START_ENABLE:
-                printPgmString(PSTR("Start limit switch on Z axis enabled\r\n"));
-                break;
-            default:
-                printPgmString(PSTR("Unknown error "));
-                printInteger(status_code);
-                printPgmString(PSTR("\r\n"));
-        }
+        status_text(status_code);
+    }
+}
+
+/**
+ * Report a limit switch hit of the step interrupt as soon as it happens
+ * The lines of the moves were acknowledged when they were queued, so it is
+ * an alarm of its own and not the answer to a line
+ */
+static void limit_message() {
+    uint8_t status = st_limit_status();
+    if (status != STATUS_OK) {
+        printPgmString(PSTR("ALARM: "));
+        status_text(status);
     }
 }
 
@@ -131,9 +154,12 @@ uint8_t protocol_execute_line(char *line) {
  */
 void protocol_process() {
     char c;
+    limit_message();
     while ((c = serial_read()) != SERIAL_NO_DATA) {
         //End of line reached
         if ((c == '\n') || (c == '\r')) { 
+            //A hit during the previous lines comes before the answer to this one
+            limit_message();
             //Line is complete. Then execute!
             if (char_counter > 0) {
                 //Terminate string
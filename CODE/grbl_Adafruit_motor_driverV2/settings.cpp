@@ -27,6 +27,7 @@
 
 #include <avr/io.h>
 #include <math.h>
+#include <stddef.h>
 #include "nuts_bolts.h"
 #include "settings.h"
 #include "eeprom.h"
@@ -35,6 +36,7 @@
 #include "protocol.h"
 #include "config.h"
 #include "stepper_control.h"
+#include "limit_switch.h"
 
 
 settings_t settings;
@@ -50,6 +52,24 @@ typedef struct {
 
 
 
+/**
+ * Set the acceleration settings added in version 5 to default
+ */
+static void settings_reset_acceleration() {
+    settings.acceleration[X_AXIS] = DEFAULT_X_ACCELERATION;
+    settings.acceleration[Y_AXIS] = DEFAULT_Y_ACCELERATION;
+    settings.acceleration[Z_AXIS] = DEFAULT_Z_ACCELERATION;
+    settings.junction_deviation = DEFAULT_JUNCTION_DEVIATION;
+}
+
+/**
+ * Set the idle hold settings added in version 6 to default
+ */
+static void settings_reset_idle_hold() {
+    settings.idle_hold_delay = DEFAULT_IDLE_HOLD_DELAY;
+    settings.idle_hold_current = DEFAULT_IDLE_HOLD_CURRENT;
+}
+
 /**
  * Set settings values to default
  */
@@ -74,6 +94,8 @@ void settings_reset() {
     
     settings.limit_switch = DEFAULT_LIMIT_SWITCH;
     settings.release_after_move = RELEASE_AFTER_MOVE;
+    settings_reset_acceleration();
+    settings_reset_idle_hold();
 }
 
 /**
@@ -168,6 +190,32 @@ void settings_dump() {
     printPgmString(PSTR("\r\n $18 = "));
     printInteger(0); 
     printPgmString(PSTR(" (1 to reset setings)\r\n"));
+
+    //Acceleration
+    printPgmString(PSTR("\r\n $19 = "));
+    printFloat(settings.acceleration[X_AXIS]);
+    printPgmString(PSTR(" (mm/sec^2 x acceleration)\r\n"));
+
+    printPgmString(PSTR("\r\n $20 = "));
+    printFloat(settings.acceleration[Y_AXIS]);
+    printPgmString(PSTR(" (mm/sec^2 y acceleration)\r\n"));
+
+    printPgmString(PSTR("\r\n $21 = "));
+    printFloat(settings.acceleration[Z_AXIS]);
+    printPgmString(PSTR(" (mm/sec^2 z acceleration)\r\n"));
+
+    printPgmString(PSTR("\r\n $22 = "));
+    printFloat(settings.junction_deviation);
+    printPgmString(PSTR(" (mm junction deviation, cornering speed)\r\n"));
+
+    //Idle hold
+    printPgmString(PSTR("\r\n $23 = "));
+    printFloat(settings.idle_hold_delay);
+    printPgmString(PSTR(" (sec idle before reducing the holding current)\r\n"));
+
+    printPgmString(PSTR("\r\n $24 = "));
+    printFloat(settings.idle_hold_current);
+    printPgmString(PSTR(" (% of full current when idle, 100 to disable)\r\n"));
     printPgmString(PSTR("\r\n'$x=value' to set parameter or just '$' to dump current settings\r\n"));
 }
 
@@ -243,12 +291,31 @@ int read_settings() {
         if (!(memcpy_from_eeprom_with_checksum((unsigned char*)&settings, 1, sizeof(settings_v1_t)))) {
             return(false);
         }
+        settings_reset_acceleration();
+        settings_reset_idle_hold();
+        write_settings();
+    } else if (version == 4) {
+        //Migrate from settings version 4, the acceleration settings are new
+        if (!(memcpy_from_eeprom_with_checksum((unsigned char*)&settings, 1, offsetof(settings_t, acceleration)))) {
+            return(false);
+        }
+        settings_reset_acceleration();
+        settings_reset_idle_hold();
+        write_settings();
+    } else if (version == 5) {
+        //Migrate from settings version 5, the idle hold settings are new
+        if (!(memcpy_from_eeprom_with_checksum((unsigned char*)&settings, 1, offsetof(settings_t, idle_hold_delay)))) {
+            return(false);
+        }
+        settings_reset_idle_hold();
         write_settings();
     } else if ((version == 2) || (version == 3)) {
-        //Migrate from settings version 2 and 3
-        if (!(memcpy_from_eeprom_with_checksum((unsigned char*)&settings, 1, sizeof(settings_t)))) {
+        //Migrate from settings version 2 and 3, stored without the acceleration and idle hold settings
+        if (!(memcpy_from_eeprom_with_checksum((unsigned char*)&settings, 1, offsetof(settings_t, acceleration)))) {
             return(false);
         }
+        settings_reset_acceleration();
+        settings_reset_idle_hold();
         write_settings();
     } else {      
         return(false);
@@ -302,6 +369,7 @@ void settings_store_setting(int parameter, double value) {
             break;
         case 12: 
             settings.limit_switch = value;
+            ls_init();
             break;
         case 13: 
             settings.release_after_move = value;
@@ -328,11 +396,40 @@ void settings_store_setting(int parameter, double value) {
         case 18: 
             if(value == 1){
                 settings_reset();
+                ls_init();
                 write_settings();
                 settings_dump();
                 printPgmString(PSTR("\r\nSetings reseted\r\n"));
             }
             break;
+        case 19: case 20: case 21:
+            if (value <= 0.0) {
+                printPgmString(PSTR("Acceleration must be > 0.0\r\n"));
+                return;
+            }
+            settings.acceleration[parameter - 19] = value;
+            break;
+        case 22:
+            if (value <= 0.0) {
+                printPgmString(PSTR("Junction deviation must be > 0.0\r\n"));
+                return;
+            }
+            settings.junction_deviation = value;
+            break;
+        case 23:
+            if (value < 0.0) {
+                printPgmString(PSTR("Idle hold delay must be >= 0.0\r\n"));
+                return;
+            }
+            settings.idle_hold_delay = value;
+            break;
+        case 24:
+            if (value < 0.0 || value > 100.0) {
+                printPgmString(PSTR("Idle hold current must be 0-100\r\n"));
+                return;
+            }
+            settings.idle_hold_current = value;
+            break;
         default: 
             printPgmString(PSTR("\r\nUnknown parameter\r\n"));
             return;
@@ -30,7 +30,7 @@
 
 //Version of the EEPROM data. Will be used to migrate existing data from older versions of Grbl
 //When firmware is upgraded. Always stored in byte 0 of eeprom
-#define SETTINGS_VERSION 4
+#define SETTINGS_VERSION 6
 
 //Current global settings (persisted in EEPROM from byte 1 onwards)
 typedef struct {
@@ -45,6 +45,10 @@ typedef struct {
     double work_area[3];
     bool limit_switch;
     bool release_after_move;
+    double acceleration[3];
+    double junction_deviation;
+    double idle_hold_delay;
+    double idle_hold_current;
 } settings_t;
 
 extern settings_t settings;
@@ -0,0 +1,123 @@
+/*
+ * step_schedule.cpp - step event deadlines on the timer 1 timeline
+ */
+/**
+ * Part of Grbl interpreter modified to work with Adafruit Motor Driver V2
+ *
+ * Timer 1 runs free at F_CPU/8 (0.5us per tick at 16MHz) and every step event
+ * gets an absolute deadline on that timeline: the deadline of the previous
+ * event plus the period from the trapezoid. The fraction of a tick is carried
+ * over, so rounding does not add up along a line. The step interrupt is late
+ * on its deadline and the coil update of each step takes a while on I2C, but
+ * neither delays the next deadline because it is not measured from the moment
+ * the interrupt ran.
+ * The mean feed rate is therefore the planned rate to within 0.01% plus the
+ * crystal tolerance (0.5% on a resonator board), as long as the I2C writes of
+ * a step fit in its period. test/test_step_schedule.cpp checks that against a
+ * fake clock.
+ * The coils of a shield latch on the STOP of its transaction, not on the
+ * deadline. That comes after the interrupt latency, the staging of the step,
+ * any transaction still ahead in the TWI queue and the transaction itself, at
+ * 22.5us per byte at 400kHz. A full step of one motor is a 10 byte burst, so
+ * its coils switch 0.25-0.3ms after the deadline, and up to about 0.75ms
+ * for the last shield when all three motors step. The step edges jitter by
+ * the difference in these delays from one step to the next, which does not
+ * add up either.
+ * A step that misses its deadline goes out right away and the timeline
+ * restarts from there, the time is not made up with a burst of steps the
+ * motor could not follow.
+ */
+
+#include <math.h>
+
+#include "config.h"
+#include "planner.h"
+#include "step_schedule.h"
+
+//Compare value of the event the interrupt was scheduled for
+static uint16_t st_deadline;
+//Ticks left until the next step event and the fraction of a tick carried over, in 1/256 ticks
+static uint32_t st_ticks_pending;
+static uint8_t st_tick_fraction;
+
+/**
+ * Start a new timeline
+ *
+ * @param uint16_t now  timer count
+ * @return uint16_t compare value
+ */
+uint16_t schedule_start(uint16_t now) {
+    st_deadline = now;
+    st_ticks_pending = 0;
+    st_tick_fraction = 0;
+    return schedule_chunk(now);
+}
+
+/**
+ * Work out the compare for the next chunk of the pending wait
+ * Restarts the timeline if the deadline already passed
+ *
+ * @param uint16_t now  timer count
+ * @return uint16_t compare value
+ */
+uint16_t schedule_chunk(uint16_t now) {
+    uint16_t chunk = st_ticks_pending;
+    if (st_ticks_pending > STEP_TIMER_MAX_CHUNK) {
+        //Leave at least half a chunk for the last one, a few ticks would be due before the interrupt is back
+        chunk = (st_ticks_pending > STEP_TIMER_MAX_CHUNK * 3 / 2) ? STEP_TIMER_MAX_CHUNK : st_ticks_pending / 2;
+    }
+    st_ticks_pending -= chunk;
+    st_deadline += chunk;
+    int16_t lead = st_deadline - now;
+    if (lead < STEP_TIMER_MIN_LEAD || lead > STEP_TIMER_MAX_CHUNK + STEP_TIMER_MIN_LEAD) {
+        st_deadline = now + STEP_TIMER_MIN_LEAD;
+    }
+    return st_deadline;
+}
+
+/**
+ * Schedule the next step event ticks_fp/256 timer ticks after the current deadline
+ *
+ * @param uint32_t ticks_fp
+ * @param uint16_t now  timer count
+ * @return uint16_t compare value
+ */
+uint16_t schedule_step_event(uint32_t ticks_fp, uint16_t now) {
+    ticks_fp += st_tick_fraction;
+    st_tick_fraction = ticks_fp & 0xff;
+    st_ticks_pending = ticks_fp >> 8;
+    return schedule_chunk(now);
+}
+
+bool schedule_pending() {
+    return st_ticks_pending > 0;
+}
+
+/**
+ * Work out the period up to the next step event from the trapezoid of the
+ * block: accelerate from initial_rate, cruise at nominal_rate and
+ * decelerate to final_rate with v^2 = v0^2 + 2*a*s
+ *
+ * @param block_t block
+ * @param uint32_t step_events_completed
+ * @return uint32_t period in 1/256 timer ticks
+ */
+uint32_t trapezoid_step_ticks(const block_t *block, uint32_t step_events_completed) {
+    double rate;
+    if (step_events_completed < block->accelerate_until) {
+        rate = sqrt(block->initial_rate * block->initial_rate +
+            2 * block->rate_acceleration * step_events_completed);
+    } else if (step_events_completed > block->decelerate_after) {
+        rate = sqrt(block->final_rate * block->final_rate +
+            2 * block->rate_acceleration * (block->step_event_count - step_events_completed));
+    } else {
+        rate = block->nominal_rate;
+    }
+    if (rate > block->nominal_rate) {
+        rate = block->nominal_rate;
+    }
+    if (rate < MINIMUM_STEPS_PER_MINUTE) {
+        rate = MINIMUM_STEPS_PER_MINUTE;
+    }
+    return (F_CPU / 8 * 60.0 * 256) / rate;
+}
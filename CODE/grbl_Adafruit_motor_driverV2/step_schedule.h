@@ -0,0 +1,36 @@
+/*
+ * step_schedule.h - step event deadlines on the timer 1 timeline
+ */
+/**
+ * Part of Grbl interpreter modified to work with Adafruit Motor Driver V2
+ */
+
+#ifndef step_schedule_h
+#define step_schedule_h
+
+#include <inttypes.h>
+#include "planner.h"
+
+//Longest wait programmed into the 16 bit compare at once, longer periods are chained
+#define STEP_TIMER_MAX_CHUNK 0x4000
+//Shortest lead between programming the compare and the match
+#define STEP_TIMER_MIN_LEAD 20
+
+//Start a new timeline at timer count now, the first event is due right away
+//Returns the compare value
+uint16_t schedule_start(uint16_t now);
+
+//Compare value for the next chunk of the pending wait, now is the timer count
+uint16_t schedule_chunk(uint16_t now);
+
+//Schedule the next step event ticks_fp/256 timer ticks after the current deadline
+//Returns the compare value of its first chunk
+uint16_t schedule_step_event(uint32_t ticks_fp, uint16_t now);
+
+//True while the compare is a chunk of a long period, not a step event yet
+bool schedule_pending();
+
+//Period up to the next step event of block after step_events_completed, in 1/256 timer ticks
+uint32_t trapezoid_step_ticks(const block_t *block, uint32_t step_events_completed);
+
+#endif
@@ -12,9 +12,9 @@
  * email <vasiliu.catalin.mihai@gmail.com>
  */
 
-#include <Wire.h>
 #include <Adafruit_MotorShield.h>
 #include "utility/Adafruit_PWMServoDriver.h"
+#include "utility/twi_queue.h"
 
 #include <arduino.h>
 
@@ -24,6 +24,15 @@
 #include "limit_switch.h"
 #include "protocol.h"
 #include "gcode.h"
+#include "planner.h"
+#include "stepper_control.h"
+#include "step_schedule.h"
+
+#include <avr/interrupt.h>
+
+#if defined(MICROSTEPPING) && STEP_MICROSTEPS != MICROSTEPS
+#error "STEP_MICROSTEPS in config.h does not match MICROSTEPS of the motor shield library"
+#endif
 
 #define X_motor 0
 #define Y_motor 1
@@ -38,36 +47,211 @@ Adafruit_DCMotor *spindle = XSpindle_shield.getMotor(SPINDLE_PORT);
 
 static int current_direction;
 
-typedef struct {
-    long steps_to_travel;
-    long abs_steps_to_travel;
-    int dir;
-    long step_counter;
-} Axis;
+//The block the step interrupt is currently tracing
+static block_t *current_block;
+//Bresenham counters and step events done on the current block
+static long counter[3];
+static uint32_t step_events_completed;
+//True while the step interrupt is armed
+static volatile bool st_running;
+//Limit switch status raised by the step interrupt, reported by the next st_line()
+static volatile uint8_t st_status;
+//millis() when the step interrupt went idle, and whether the coils are down to the idle hold current
+static uint32_t st_idle_since;
+static bool st_holding;
 
-Axis axis[3];
+/**
+ * Program the compare of timer 1 for the next event of the step schedule
+ *
+ * @param uint16_t deadline
+ */
+static void st_set_compare(uint16_t deadline) {
+    TIFR1 = (1 << OCF1A);
+    OCR1A = deadline;
+}
 
 /**
- * Change I2C clock to 400 KHz
  * Initialize Adafruit Motor Shields
+ * Change I2C clock to SHIELD_I2C_CLOCK
+ * The shield traffic goes through the queued TWI driver, the step interrupt
+ * only builds the transactions and the TWI interrupt sends them
  */
 void shield_begin() {
-    //Change the i2c clock to 400KHz
-    TWBR = ((F_CPU / 400000l) - 16) / 2;
-
     YZ_shield.begin();
     XSpindle_shield.begin();
 
+    twi_queue_setClock(SHIELD_I2C_CLOCK);
+
    
 }
 
 /**
  * Initialize motors 
+ * Set up timer 1 for the step interrupt, it stays disabled until a block is queued
  */
 void motors_init(){
     Motor[X_motor] = XSpindle_shield.getStepper(settings.steps_per_turn[X_AXIS], 2); //x
     Motor[Y_motor] = YZ_shield.getStepper(settings.steps_per_turn[Y_AXIS], 2); //y
     Motor[Z_motor] = YZ_shield.getStepper(settings.steps_per_turn[Z_AXIS], 1); //z
+
+    //waveform generation = 0000 = normal, free running at F_CPU/8
+    TCCR1A = 0;
+    TCCR1B = (1 << CS11);
+    TIMSK1 &= ~(1 << OCIE1A);
+    current_block = NULL;
+    st_running = false;
+    st_status = STATUS_OK;
+}
+
+/**
+ * Put every motor back to full current after the idle hold, before it steps
+ * A motor that does not step would otherwise keep holding the move at the
+ * idle hold current. Only call it while the step interrupt is off, the
+ * shields are the main loop's then
+ */
+static void st_full_current() {
+    if (st_holding) {
+        for (uint8_t j = 0; j < NUM_AXIES; j++) {
+            Motor[j]->hold(100);
+        }
+        st_holding = false;
+    }
+}
+
+/**
+ * Start the idle hold delay after the limit switch searches, which step
+ * the motors without the step interrupt
+ */
+static void st_idle_from_now() {
+    st_idle_since = millis();
+    st_holding = false;
+}
+
+/**
+ * Start the step interrupt if it is not already running
+ * Called by the planner every time a block is queued
+ */
+void st_wake_up() {
+    if (!st_running) {
+        st_full_current();
+    }
+    uint8_t sreg = SREG;
+    cli();
+    if (!st_running) {
+        st_running = true;
+        //Start a new timeline
+        st_set_compare(schedule_start(TCNT1));
+        TIMSK1 |= (1 << OCIE1A);
+    }
+    SREG = sreg;
+}
+
+/**
+ * Block until all buffered steps are executed
+ * Must be called before anything else talks to the shields over I2C
+ */
+void st_synchronize() {
+    while (st_running) {
+    }
+}
+
+/**
+ * Reduce the coil current of the motors once they have been idle for
+ * settings.idle_hold_delay, called from the main loop
+ * Only talks to the shields while the step interrupt is off, which is
+ * started from the main loop as well
+ */
+void st_idle_hold() {
+    if (st_running || st_holding || settings.release_after_move == 1 || settings.idle_hold_current >= 100.0) {
+        return;
+    }
+    if (millis() - st_idle_since < settings.idle_hold_delay * 1000) {
+        return;
+    }
+    for (uint8_t j = 0; j < NUM_AXIES; j++) {
+        Motor[j]->hold(settings.idle_hold_current);
+    }
+    st_holding = true;
+}
+
+/**
+ * The step interrupt, runs once per step event of the current block
+ * The coil updates are queued for the TWI interrupt, which may have to drain
+ * the queue first, so the timer interrupt disables itself and runs the rest
+ * with global interrupts on. Serial reception and the parser in loop() keep
+ * running while the bus sends the steps.
+ */
+ISR(TIMER1_COMPA_vect) {
+    TIMSK1 &= ~(1 << OCIE1A);
+    sei();
+
+    //Part of a long period, not a step event yet
+    if (schedule_pending()) {
+        st_set_compare(schedule_chunk(TCNT1));
+        cli();
+        TIMSK1 |= (1 << OCIE1A);
+        return;
+    }
+
+    if (current_block == NULL) {
+        //The planner is rewriting the queued blocks, try again shortly
+        if (plan_is_locked()) {
+            st_set_compare(schedule_step_event((F_CPU / 8 / 10000) << 8, TCNT1));
+            cli();
+            TIMSK1 |= (1 << OCIE1A);
+            return;
+        }
+        //Anything queued for us?
+        current_block = plan_get_current_block();
+        if (current_block != NULL) {
+            current_block->busy = true;
+            counter[X_AXIS] = counter[Y_AXIS] = counter[Z_AXIS] = -(long) (current_block->step_event_count >> 1);
+            step_events_completed = 0;
+        }
+    }
+
+    if (current_block != NULL) {
+        //After a limit switch hit the rest of the buffer is dropped without moving
+        if (st_status == STATUS_OK) {
+            for (uint8_t j = 0; j < NUM_AXIES; ++j) {
+                counter[j] += current_block->steps[j];
+                if (counter[j] > 0) {
+                    counter[j] -= current_block->step_event_count;
+                    uint8_t status = st_stagestep(j, (current_block->direction_bits & (1 << j)) ? -1 : 1);
+                    if (status != STATUS_OK) {
+                        st_status = status;
+                        break;
+                    }
+                }
+            }
+            st_commit();
+        }
+        step_events_completed++;
+        //The last period of a block runs at its final rate into the first step of the next
+        st_set_compare(schedule_step_event(trapezoid_step_ticks(current_block, step_events_completed), TCNT1));
+        if (step_events_completed >= current_block->step_event_count || st_status != STATUS_OK) {
+            current_block = NULL;
+            plan_discard_current_block();
+        }
+    } else {
+        //Buffer is empty, release motors...see config.h comments for more info
+        if (settings.release_after_move == 1) {
+            for (uint8_t j = 0; j < NUM_AXIES; j++) {
+                Motor[j]->release();
+            }
+        }
+        cli();
+        //A block may have been queued while the motors were released
+        if (plan_get_current_block() == NULL) {
+            st_idle_since = millis();
+            st_running = false;
+            return;
+        }
+        st_set_compare(schedule_chunk(TCNT1));
+    }
+
+    cli();
+    TIMSK1 |= (1 << OCIE1A);
 }
 
 /**
@@ -80,6 +264,8 @@ void motors_init(){
  */
 void spindle_run(int direction, uint32_t rpm) {
     if (direction != current_direction) {
+        //finish the buffered moves first, they share the I2C bus with the spindle
+        st_synchronize();
         spindle->setSpeed(rpm);
         if (direction > 0) {
             spindle->run(FORWARD);
@@ -101,40 +287,83 @@ void spindle_stop() {
 
 /**
  * Check the limit switch according to axis and direction
- * Move the motor one step in the direction...motors are define Motor[]
+ * Stage one step of the motor in the direction...motors are define Motor[]
+ * Nothing is sent until st_commit(), so the motors of one shield that step
+ * together share a single I2C transaction
  * Return status ok or limit switch error
  * 
  * @param int motor
  * @param int direction
  * @return int status
  */
-uint8_t st_onestep(int motor, int direction) {
+uint8_t st_stagestep(int motor, int direction) {
     if(settings.limit_switch == 1){
         uint8_t switchCheck = ls_check(motor, direction);
         if (switchCheck > 0) {
             return switchCheck;
         }
     }
-    Motor[motor]->onestep(direction > 0 ? FORWARD : BACKWARD, DOUBLE);
+    Motor[motor]->stagestep(direction > 0 ? FORWARD : BACKWARD, STEPPING_STYLE);
     return STATUS_OK;
 }
 
+/**
+ * Send the staged coil changes, one transaction per shield that has any
+ */
+void st_commit() {
+    YZ_shield.commit();
+    XSpindle_shield.commit();
+}
+
+/**
+ * Check the limit switch according to axis and direction
+ * Move the motor one step in the direction right away
+ * Return status ok or limit switch error
+ * 
+ * @param int motor
+ * @param int direction
+ * @return int status
+ */
+uint8_t st_onestep(int motor, int direction) {
+    uint8_t status = st_stagestep(motor, direction);
+    st_commit();
+    return status;
+}
+
 /**
  * Pause for the @param seconds ... just delay
  * 
  * @param double seconds
  */
 void st_dwell(double seconds) {
+    st_synchronize();
     delay_ms(seconds * 1000);
 }
 
 /**
- * Move the tool from current position to xyz position in a straight line
- * Uses oneStep() function to move motors
- * Calculate the time that took to travel one step on every axes 
- * (eg x1, y1, z0 steps is approx 1.4/step_per_mm and it takes about 8ms to travel)
- * Calculate the time that the action should take according to feed_rate and pause the diference
- * Return status
+ * Take the limit switch status raised by the step interrupt
+ * After a hit the interrupt drops the rest of the buffer without moving,
+ * the status is cleared once that is done, so later moves run again
+ * 
+ * @return uint8_t status ok or the limit switch error
+ */
+uint8_t st_limit_status() {
+    if (st_status == STATUS_OK) {
+        return STATUS_OK;
+    }
+    st_synchronize();
+    uint8_t status = st_status;
+    st_status = STATUS_OK;
+    return status;
+}
+
+/**
+ * Queue a move of the tool from current position to xyz position in a straight line
+ * The planner stores the block and the step interrupt traces it with Bresenham,
+ * pacing the step events with timer 1 according to feed_rate
+ * Returns right away unless the block buffer is full, so the protocol keeps
+ * reading lines while the motors move
+ * A limit switch hit inside the interrupt is reported by protocol_process()
  * 
  * @param double[3] position  current position (gc.position)
  * @param double x 
@@ -145,69 +374,19 @@ void st_dwell(double seconds) {
  * @return int status ...from oneStep / ls_check
  */
 uint8_t st_line(double *position, double x, double y, double z, double feed_rate, uint8_t invert_feed_rate) {
-    uint8_t status = STATUS_OK;
-    //calculate steps to make on each axis
-    axis[X_AXIS].steps_to_travel = lround((x - position[X_AXIS]) * settings.steps_per_mm[X_AXIS]);
-    axis[Y_AXIS].steps_to_travel = lround((y - position[Y_AXIS]) * settings.steps_per_mm[Y_AXIS]);
-    axis[Z_AXIS].steps_to_travel = lround((z - position[Z_AXIS]) * settings.steps_per_mm[Z_AXIS]);
-
-    long i, j, maxsteps = 0;
-
-    for (i = 0; i < NUM_AXIES; ++i) {
-        //do not take minus vall
-        axis[i].abs_steps_to_travel = abs(axis[i].steps_to_travel);
-        //calculate dir
-        axis[i].dir = axis[i].steps_to_travel > 0 ? 1 : -1;
-        //get the longest distance
-        if (maxsteps < axis[i].abs_steps_to_travel) {
-            maxsteps = axis[i].abs_steps_to_travel;
-        }
-        axis[i].step_counter = 0;
+    //backstop, protocol_process() normally reports a limit switch hit right away
+    uint8_t status = st_limit_status();
+    if (status != STATUS_OK) {
+        return status;
     }
-    //store here if a step was made on a axis, need to calculate time 
-    bool axis_step[3];
-    
-    for (i = 0; i < maxsteps; ++i) {
-        //get the start time
-        unsigned long start_step_time = millis();
-        for (j = 0; j < NUM_AXIES; ++j) {
-            axis[j].step_counter += axis[j].abs_steps_to_travel;
-            if (axis[j].step_counter >= maxsteps) {
-                axis[j].step_counter -= maxsteps;
-                status = st_onestep(j, axis[j].dir);
-                //check status and return if limit reach
-                if (status != STATUS_OK) {
-                    return status;
-                }
-                axis_step[j] = 1;
-            } else {
-                axis_step[j] = 0;
-            }
-        }
-        
-        //calculate distance traveled
-        float distance_traveled_mm = sqrt( 
-            ((axis_step[X_AXIS] / settings.steps_per_mm[X_AXIS]) * (axis_step[X_AXIS] / settings.steps_per_mm[X_AXIS])) +
-            ((axis_step[Y_AXIS] / settings.steps_per_mm[Y_AXIS]) * (axis_step[Y_AXIS] / settings.steps_per_mm[Y_AXIS])) +
-            ((axis_step[Z_AXIS] / settings.steps_per_mm[Z_AXIS]) * (axis_step[Z_AXIS] / settings.steps_per_mm[Z_AXIS]))
-        );
-        
-        //calculate how much time(in milliseconds) should take to travel distance_traveled_mm according to feed rate
-        double time_should_take = distance_traveled_mm * 60000 / feed_rate;
-        //time that actualy take to travel
-        unsigned long step_time = millis() - start_step_time;
-        //calculate time to  pause, do not accept val < 0  
-        if (time_should_take - step_time > 0) {
-            delay_ms(time_should_take - step_time);
-        }
-    }
-    //release motors...see config.h comments for more info
-    if(settings.release_after_move == 1){
-        for (int j = 0; j < 3; j++) {
-            Motor[j]->release();
-        }
-    }
-    return status;
+    //calculate steps to make on each axis
+    long steps[3];
+    steps[X_AXIS] = lround((x - position[X_AXIS]) * settings.steps_per_mm[X_AXIS]);
+    steps[Y_AXIS] = lround((y - position[Y_AXIS]) * settings.steps_per_mm[Y_AXIS]);
+    steps[Z_AXIS] = lround((z - position[Z_AXIS]) * settings.steps_per_mm[Z_AXIS]);
+
+    plan_buffer_line(steps, feed_rate, invert_feed_rate);
+    return STATUS_OK;
 }
 
 /**
@@ -304,6 +483,40 @@ uint8_t st_arc(double *position, double *target, double *offset, uint8_t axis_0,
 
 }
 
+/**
+ * Step period of the limit switch searches below, one step on each moving
+ * axis per period at settings.default_feed_rate on the axis with the most
+ * steps per mm
+ *
+ * @param bool z_axis  Z moves as well
+ * @return uint32_t period in microseconds
+ */
+static uint32_t st_search_period(bool z_axis) {
+    double steps_per_mm = max(settings.steps_per_mm[X_AXIS], settings.steps_per_mm[Y_AXIS]);
+    if (z_axis) {
+        steps_per_mm = max(steps_per_mm, settings.steps_per_mm[Z_AXIS]);
+    }
+    double steps_per_minute = max(settings.default_feed_rate * steps_per_mm, (double) MINIMUM_STEPS_PER_MINUTE);
+    return 60000000.0 / steps_per_minute;
+}
+
+/**
+ * Wait for the next step of a limit switch search
+ * The steps so far are flushed to the shields first, so the limit checks of
+ * the next step see the switches where the motors actually are
+ *
+ * @param uint32_t next_step  micros() of the next step, advanced by period
+ * @param uint32_t period
+ */
+static void st_search_pace(uint32_t *next_step, uint32_t period) {
+    twi_queue_flush();
+    uint32_t now = micros();
+    while ((int32_t) (now - *next_step) < 0) {
+        now = micros();
+    }
+    *next_step = now + period;
+}
+
 /**
  * put all motors to mechanical zero except the z axis witch is optional
  * be aware of the tool on z axis, it may be lower so it can not reach the limit 
@@ -314,12 +527,17 @@ uint8_t st_arc(double *position, double *target, double *offset, uint8_t axis_0,
  * @param bool zero_Z_axis   
  */
 void st_go_to_zero(bool zero_Z_axis) {
+    st_synchronize();
+    st_full_current();
     if(settings.limit_switch == 1){
         uint8_t xLimit = 0;
         uint8_t yLimit = 0;
         uint8_t zLimit = 0;
+        uint32_t period = st_search_period(zero_Z_axis);
+        uint32_t next_step = micros();
 
         while (true) {
+            st_search_pace(&next_step, period);
             if (st_onestep(X_AXIS, -1) == X_LIMIT_START_ENABLE) {
                 xLimit = 1;
             }
@@ -339,6 +557,7 @@ void st_go_to_zero(bool zero_Z_axis) {
                 }
             }
         }
+        st_idle_from_now();
     }
 }
 
@@ -350,6 +569,8 @@ void st_go_to_zero(bool zero_Z_axis) {
  * Works only with limit switch !!!
  */
 void st_calibrate() {
+    st_synchronize();
+    st_full_current();
     if(settings.limit_switch == 1){
         //Go all to 0
         st_go_to_zero(true);
@@ -361,8 +582,11 @@ void st_calibrate() {
         double xCounter = 0;
         double yCounter = 0;
         double zCounter = 0;
+        uint32_t period = st_search_period(true);
+        uint32_t next_step = micros();
 
         while (true) {
+            st_search_pace(&next_step, period);
             if (st_onestep(X_AXIS, 1) == X_LIMIT_END_ENABLE) {
                 xLimit = 1;
             } else {
@@ -385,6 +609,7 @@ void st_calibrate() {
         settings.work_area[X_AXIS] = xCounter / settings.steps_per_mm[X_AXIS];
         settings.work_area[Y_AXIS] = yCounter / settings.steps_per_mm[Y_AXIS];
         settings.work_area[Z_AXIS] = zCounter / settings.steps_per_mm[Z_AXIS];
+        st_idle_from_now();
     }
 }
 
@@ -396,11 +621,16 @@ void st_calibrate() {
  * x axis to minimum ad y axis to maximum
  */
 void st_machine_park(){
+    st_synchronize();
+    st_full_current();
     if(settings.limit_switch == 1){
         uint8_t xLimit = 0;
         uint8_t yLimit = 0;
+        uint32_t period = st_search_period(false);
+        uint32_t next_step = micros();
 
         while (true) {
+            st_search_pace(&next_step, period);
             if (st_onestep(X_AXIS, -1) == X_LIMIT_START_ENABLE) {
                 xLimit = 1;
             }
@@ -411,5 +641,6 @@ void st_machine_park(){
                 break;
             }
         }
+        st_idle_from_now();
     }
 }
\ No newline at end of file
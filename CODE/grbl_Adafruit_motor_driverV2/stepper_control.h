@@ -14,6 +14,20 @@ void spindle_run(int direction, uint32_t rpm);
 void spindle_stop();
 
 uint8_t st_onestep(int motor, int direction);
+uint8_t st_stagestep(int motor, int direction);
+void st_commit();
+
+//Start the step interrupt if it is idle
+void st_wake_up();
+
+//Block until all buffered steps are executed
+void st_synchronize();
+
+//Limit switch hit by the step interrupt, cleared once the buffer is dropped
+uint8_t st_limit_status();
+
+//Drop the coils to the idle hold current after the idle delay, call it from the main loop
+void st_idle_hold();
 
 void st_go_home(double *position);
 
@@ -0,0 +1,204 @@
+/*
+ * test_step_schedule.cpp - step schedule replayed against a fake timer 1
+ */
+/**
+ * Part of Grbl interpreter modified to work with Adafruit Motor Driver V2
+ *
+ * A 32 bit tick count stands in for timer 1, and the step interrupt is run
+ * the way stepper_control.cpp does it: a compare match enters it after some
+ * latency, a step event stages the coils of the motors that step, queues one
+ * transaction per shield and schedules the next event. A model of the I2C bus
+ * sends the transactions in order at 400kHz and gives the moment the coils of
+ * each shield latch.
+ * A block that starts and ends at MINIMUM_STEPS_PER_MINUTE, so its slow steps
+ * are chained over several compare chunks, must take the time of its planned
+ * trapezoid to within the stated 0.01%, and the coils must latch within the
+ * bound the documentation gives after each deadline. So must a cruise with a
+ * period just over one chunk. A step that is held up well past its deadline
+ * must not be made up with a burst of steps.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "config.h"
+#include "planner.h"
+#include "step_schedule.h"
+
+#define TICKS_PER_SECOND (F_CPU / 8)
+#define TICKS_PER_BYTE 45      //9 bits at 400kHz
+#define BYTES_PER_MOTOR 10     //address, register and two adjacent channels of a full step
+#define LATENCY_MAX 20         //interrupt latency, in ticks
+#define STAGE_MIN 40           //Bresenham, limit switch check and staging, in ticks
+#define STAGE_MAX 100
+#define MAX_STEPS 4000
+
+static const long steps[3] = { 3000, 1500, 700 };
+static block_t block;
+
+static uint32_t now;           //fake timer 1, the low 16 bits are TCNT1
+static uint32_t bus_free;      //tick the I2C bus finishes the queued transactions
+static uint32_t seed = 1;
+
+static uint32_t deadline[MAX_STEPS];
+static uint32_t latched[MAX_STEPS];
+static uint32_t latch_bound[MAX_STEPS];
+static uint32_t n_steps;
+static int failed;
+
+static uint32_t random_ticks(uint32_t low, uint32_t high) {
+    seed = seed * 1103515245 + 12345;
+    return low + (seed >> 16) % (high - low + 1);
+}
+
+//Tick of the compare match of a compare value programmed at now
+static uint32_t match_tick(uint16_t compare) {
+    return now + (uint16_t) (compare - (uint16_t) now);
+}
+
+//Queue a transaction for a shield, returns the tick its STOP latches the coils
+static uint32_t bus_send(uint8_t motors) {
+    uint32_t start = (bus_free > now) ? bus_free : now;
+    bus_free = start + motors * BYTES_PER_MOTOR * TICKS_PER_BYTE;
+    return bus_free;
+}
+
+/**
+ * Run the block through the step interrupt, holding up step hold_step by
+ * hold_ticks on top of its staging
+ */
+static void run_block(uint32_t hold_step, uint32_t hold_ticks) {
+    long counter[3];
+    for (uint8_t j = 0; j < 3; j++) {
+        counter[j] = -(long) (block.step_event_count >> 1);
+    }
+    uint32_t step_events_completed = 0;
+    n_steps = 0;
+    bus_free = 0;
+    now = 0x1234;
+    uint32_t match = match_tick(schedule_start(now));
+    while (step_events_completed < block.step_event_count) {
+        now = match + random_ticks(0, LATENCY_MAX);
+        if (schedule_pending()) {
+            match = match_tick(schedule_chunk(now));
+            continue;
+        }
+        deadline[n_steps] = match;
+        now += random_ticks(STAGE_MIN, STAGE_MAX);
+        if (n_steps == hold_step) {
+            now += hold_ticks;
+        }
+        uint8_t yz_motors = 0, x_motors = 0;
+        for (uint8_t j = 0; j < 3; j++) {
+            counter[j] += steps[j];
+            if (counter[j] > 0) {
+                counter[j] -= block.step_event_count;
+                if (j == 0) {
+                    x_motors++;
+                } else {
+                    yz_motors++;
+                }
+            }
+        }
+        //st_commit() queues the YZ shield first
+        latched[n_steps] = yz_motors ? bus_send(yz_motors) : now;
+        if (x_motors) {
+            latched[n_steps] = bus_send(x_motors);
+        }
+        latch_bound[n_steps] = LATENCY_MAX + STAGE_MAX + (x_motors + yz_motors) * BYTES_PER_MOTOR * TICKS_PER_BYTE;
+        n_steps++;
+        step_events_completed++;
+        match = match_tick(schedule_step_event(trapezoid_step_ticks(&block, step_events_completed), now));
+    }
+}
+
+//Planned duration of the block from its first to its last step event, in seconds
+static double planned_seconds() {
+    double seconds = 0;
+    for (uint32_t n = 1; n < block.step_event_count; n++) {
+        double rate;
+        if (n < block.accelerate_until) {
+            rate = sqrt(block.initial_rate * block.initial_rate + 2 * block.rate_acceleration * n);
+        } else if (n > block.decelerate_after) {
+            rate = sqrt(block.final_rate * block.final_rate + 2 * block.rate_acceleration * (block.step_event_count - n));
+        } else {
+            rate = block.nominal_rate;
+        }
+        rate = fmin(fmax(rate, MINIMUM_STEPS_PER_MINUTE), block.nominal_rate);
+        seconds += 60.0 / rate;
+    }
+    return seconds;
+}
+
+static void fail(const char *test, const char *message, double value) {
+    failed++;
+    printf("test_step_schedule: %s: %s %g\n", test, message, value);
+}
+
+int main() {
+    //3000 steps at 1000 steps/s, accelerating from and decelerating to the minimum rate in 500 steps
+    block.step_event_count = steps[0];
+    block.nominal_rate = 60000;
+    block.initial_rate = MINIMUM_STEPS_PER_MINUTE;
+    block.final_rate = MINIMUM_STEPS_PER_MINUTE;
+    block.rate_acceleration = (block.nominal_rate * block.nominal_rate - block.initial_rate * block.initial_rate) / (2 * 500);
+    block.accelerate_until = 500;
+    block.decelerate_after = block.step_event_count - 500;
+
+    //Feed rate: the step events follow the planned trapezoid
+    run_block(MAX_STEPS, 0);
+    double planned = planned_seconds();
+    double actual = (double) (deadline[n_steps - 1] - deadline[0]) / TICKS_PER_SECOND;
+    double error = actual / planned - 1;
+    if (fabs(error) > 1e-4) {
+        fail("feed rate", "relative error", error);
+    }
+    //Jitter: the coils latch within the documented bound after their deadline
+    uint32_t max_delay = 0, min_delay = 0xffffffff, max_bound = 0;
+    for (uint32_t i = 0; i < n_steps; i++) {
+        uint32_t delay = latched[i] - deadline[i];
+        if (delay > latch_bound[i]) {
+            fail("jitter", "coils latched late by us", delay / 2.0);
+        }
+        if (delay > max_delay) max_delay = delay;
+        if (delay < min_delay) min_delay = delay;
+        if (latch_bound[i] > max_bound) max_bound = latch_bound[i];
+    }
+    printf("test_step_schedule: %u steps in %.6fs, planned %.6fs (%+.5f%%), coils latch %.1f-%.1fus after the deadline (bound %.1fus)\n",
+        (unsigned) n_steps, actual, planned, error * 100, min_delay / 2.0, max_delay / 2.0, max_bound / 2.0);
+
+    //Chained periods: a cruise whose period is a few ticks over one compare chunk
+    block_t ramp = block;
+    block.step_event_count = 200;
+    block.nominal_rate = 60.0 * TICKS_PER_SECOND / (STEP_TIMER_MAX_CHUNK + 5);
+    block.initial_rate = block.final_rate = block.nominal_rate;
+    block.accelerate_until = 0;
+    block.decelerate_after = block.step_event_count;
+    run_block(MAX_STEPS, 0);
+    planned = planned_seconds();
+    actual = (double) (deadline[n_steps - 1] - deadline[0]) / TICKS_PER_SECOND;
+    error = actual / planned - 1;
+    if (fabs(error) > 1e-4) {
+        fail("chained", "relative error", error);
+    }
+    block = ramp;
+
+    //No burst: a step held up by 3 periods in the cruise restarts the timeline
+    const uint32_t held = 1500;
+    const uint32_t period = (uint32_t) (TICKS_PER_SECOND * 60.0 / block.nominal_rate);
+    run_block(held, 3 * period);
+    for (uint32_t i = held + 1; i < block.decelerate_after - 1; i++) {
+        int32_t interval = deadline[i + 1] - deadline[i];
+        if (abs(interval - (int32_t) period) > 1) {
+            fail("hold", "step interval after the held step in us", interval / 2.0);
+            break;
+        }
+    }
+    if (deadline[held + 1] - deadline[held] < 3 * period) {
+        fail("hold", "held step followed after us", (deadline[held + 1] - deadline[held]) / 2.0);
+    }
+
+    printf("test_step_schedule: %d failures\n", failed);
+    return failed ? 1 : 0;
+}
@@ -37,6 +37,14 @@
 #define LED0_OFF_L 0x8
 #define LED0_OFF_H 0x9
 
+#ifdef __AVR__
+ // all 16 channels fit in one queued transaction
+ #define PCA9685_BURST_CHANNELS 16
+#else
+ // Wire sends at most 32 bytes per transmission, one goes to the register address
+ #define PCA9685_BURST_CHANNELS 7
+#endif
+
 #define ALLLED_ON_L 0xFA
 #define ALLLED_ON_H 0xFB
 #define ALLLED_OFF_L 0xFC
@@ -50,10 +58,22 @@ class Adafruit_PWMServoDriver {
   void reset(void);
   void setPWMFreq(float freq);
   void setPWM(uint8_t num, uint16_t on, uint16_t off);
+  void stagePWM(uint8_t num, uint16_t on, uint16_t off);
+  void writePWM(uint8_t first, uint8_t count);
+  void commitPWM(void);
 
  private:
   uint8_t _i2caddr;
-
+  // shadow image of the LEDn_ON/LEDn_OFF registers
+  uint16_t _on[16], _off[16];
+  // bit n: channel n of the image is known to match the chip
+  uint16_t _known;
+  // bit n: channel n was staged and not sent yet
+  uint16_t _dirty;
+  // twi_queue_errors() when the image was last checked against them
+  uint8_t _errors;
+
+  void checkErrors(void);
   uint8_t read8(uint8_t addr);
   void write8(uint8_t addr, uint8_t d);
 };